@@ -11,10 +11,60 @@ Features: Route optimization, fare calculation, card compatibility
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <math.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DENSE_X86 1
+#endif
 #define MAX_STATIONS 40
 #define MAX_ROUTES 1000
 #define MAX_PATH_LENGTH 20
 #define INFINITY_DIST 9999
+#define MAX_READER_THREADS 16
+#define MAIN_READER_SLOT 0
+#define FEED_FILE "edge_updates.feed"
+#define FEED_POLL_MS 200
+#define MAX_FEED_BATCH 256
+#define MAX_EDGES (MAX_STATIONS * MAX_STATIONS)
+#define MAX_BUCKETS (INFINITY_DIST + 1)
+#define MAX_LINES 16
+#define LOCAL_LINE (MAX_LINES - 1)
+#define MAX_TRANSFER_NODES (MAX_STATIONS * MAX_LINES)
+#define MIN_CHANGE_TIME_BASE 2
+#define MIN_CHANGE_TIME_PER_PLATFORM 1
+#define MAX_TRANSFER_PENALTY 60
+#define MAX_ALTERNATIVES 4
+#define ALT_MAX_STRETCH_PERCENT 140
+#define ALT_MAX_OVERLAP_PERCENT 60
+#define TOP_HUBS 10
+#define EARTH_RADIUS_KM 6371.0
+#define REFERENCE_LATITUDE 28.61
+#define WALK_MINUTES_PER_KM 12
+#define NEAREST_CANDIDATES 3
+#define MAX_NEAREST 10
+#define COORDINATES_FILE "station_coords.csv"
+#define DENSE_BLOCK 16
+#define PADDED_STATIONS (((MAX_STATIONS + DENSE_BLOCK - 1) / DENSE_BLOCK) * DENSE_BLOCK)
+#define DENSE_INFINITY (1 << 28)
+#define DENSE_ALIGNMENT 64
+#define MAX_DENSE_KERNELS 4
+#define MATRIX_CSV_FILE "od_matrix.csv"
+#define MATRIX_BIN_FILE "od_matrix.bin"
+#define WEIGHT_SCALE 10
+#define BENCHMARK_ROUNDS 2000
+#define SNAPSHOT_FILE "bus_routes.dat"
+#define SNAPSHOT_TEMP_FILE "bus_routes.dat.tmp"
+#define SNAPSHOT_MAGIC "BUSSNAP"
+#define SNAPSHOT_FORMAT_VERSION 4
+#define JOURNAL_FILE "bus_routes.journal"
+#define JOURNAL_COMPACT_THRESHOLD 1000
+#define JOURNAL_BATCH_END 1
+#define JOURNAL_FEED_OFFSET 2
 // ==================== STRUCTURES AND UNIONS ====================
 // Structure to represent a bus station
 typedef struct {
@@ -23,6 +73,8 @@ char name[50];
 char cardType[30];
 int platform;
 char zone[20];
+double latitude;
+double longitude;
 } Station;
 // Structure to represent a route between stations
 typedef struct {
@@ -36,12 +88,195 @@ int crowd;
 // Structure to store complete path information
 typedef struct {
 int stations[MAX_PATH_LENGTH];
+int lines[MAX_PATH_LENGTH];
+int transfers;
 int pathLength;
 int totalDistance;
 int totalFare;
 int totalTime;
 int avgCrowd;
 } PathInfo;
+// Edge attribute changed by a live update record
+typedef enum {
+FIELD_DISTANCE,
+FIELD_FARE,
+FIELD_TIME,
+FIELD_CROWD,
+FIELD_LINE
+} EdgeField;
+// Cost metric used by the shortest-path searches
+typedef enum {
+METRIC_DISTANCE,
+METRIC_FARE,
+METRIC_TIME,
+METRIC_CROWD,
+METRIC_WEIGHTED,
+METRIC_COUNT
+} SearchMetric;
+// Number of metrics stored per edge; the weighted cost is combined from them
+#define STORED_METRICS METRIC_WEIGHTED
+// Weights of the combined cost in 1/WEIGHT_SCALE units, so the default
+// time + 0.5*fare + 1*crowd keeps integer costs for the bucket queue
+typedef struct {
+int timeWeight;
+int fareWeight;
+int crowdWeight;
+} CostWeights;
+// Structure for one (from, to, field, value) record of the live update feed
+typedef struct {
+int from;
+int to;
+int field;
+int value;
+} EdgeUpdate;
+// Structure for one journal record: an edge update stamped with its
+// sequence number and a CRC-32 of everything before the checksum field.
+// The last record of each edit carries JOURNAL_BATCH_END so an edit made of
+// several records is replayed all or nothing. A feed batch ends with a
+// JOURNAL_FEED_OFFSET record holding how far into FEED_FILE it has read
+// (high bits in from, low 31 bits in value) instead of an edge update.
+typedef struct {
+long sequence;
+int from;
+int to;
+int field;
+int value;
+int flags;
+unsigned int checksum;
+} JournalRecord;
+// Header written at the start of every snapshot file
+typedef struct {
+char magic[8];
+int formatVersion;
+long lastSequence;
+long feedOffset;
+} SnapshotHeader;
+// Immutable version of the network read by queries. A new version is built
+// for every edit and published by swapping liveNetwork; the old one is freed
+// once no reader still holds an epoch older than its retirement.
+typedef struct NetworkVersion {
+long versionNumber;
+int adjacencyMatrix[MAX_STATIONS][MAX_STATIONS];
+int fareMatrix[MAX_STATIONS][MAX_STATIONS];
+int timeMatrix[MAX_STATIONS][MAX_STATIONS];
+int crowdMatrix[MAX_STATIONS][MAX_STATIONS];
+int lineMatrix[MAX_STATIONS][MAX_STATIONS];
+// Compact adjacency index rebuilt on publish: the neighbours of station i
+// are edgeTarget[edgeStart[i] .. edgeStart[i+1]-1]
+int edgeCount;
+int edgeStart[MAX_STATIONS + 1];
+int edgeTarget[MAX_EDGES];
+int edgeWeight[STORED_METRICS][MAX_EDGES];
+int maxEdgeWeight[STORED_METRICS];
+// Expanded station/line graph for transfer-aware routing. Only lines that
+// actually serve a station get a node there; the node for (station, line)
+// is transferNodeStart[station] plus the rank of line in stationLineMask.
+// Transfers between a station's nodes are implicit and cost changeTime.
+int changeTime[MAX_STATIONS];
+unsigned int stationLineMask[MAX_STATIONS];
+int transferNodeCount;
+int transferNodeStart[MAX_STATIONS + 1];
+int nodeStation[MAX_TRANSFER_NODES];
+int nodeLine[MAX_TRANSFER_NODES];
+int rideStart[MAX_TRANSFER_NODES + 1];
+int rideTarget[MAX_EDGES];
+int rideTime[MAX_EDGES];
+// Connectivity index: stations in different components can never be joined
+int componentCount;
+int componentId[MAX_STATIONS];
+// Spatial index: station positions projected to km on a plane and a static
+// k-d tree stored implicitly in kdOrder (each range's middle entry splits
+// it, on x at even depths and y at odd ones). heuristicScale[m] is the
+// smallest metric cost per straight-line km over all connections, so
+// scale * distance never overestimates and is a consistent A* bound.
+int hasCoordinates;
+double stationX[MAX_STATIONS];
+double stationY[MAX_STATIONS];
+int kdOrder[MAX_STATIONS];
+double heuristicScale[STORED_METRICS];
+// Dense per-metric cost matrices for the SIMD kernels, padded to whole
+// DENSE_BLOCK-wide rows and aligned for vector loads. Missing connections
+// and padding hold DENSE_INFINITY, which can be added twice without overflow.
+int denseMatrix[STORED_METRICS][PADDED_STATIONS][PADDED_STATIONS] __attribute__((aligned(DENSE_ALIGNMENT)));
+unsigned long retireEpoch;
+struct NetworkVersion *nextRetired;
+} NetworkVersion;
+// Per-query scratch for the bucket-queue search. Stations waiting in the
+// queue sit in circular buckets indexed by cost modulo (max edge weight + 1).
+typedef struct {
+int cost[MAX_STATIONS];
+int settled[MAX_STATIONS];
+int bucketHead[MAX_BUCKETS];
+int nextInBucket[MAX_STATIONS];
+int prevInBucket[MAX_STATIONS];
+int order[MAX_STATIONS];
+int parent[MAX_STATIONS];
+int reachedCount;
+} SearchScratch;
+// Per-query scratch for the transfer-aware search on the expanded graph
+typedef struct {
+int cost[MAX_TRANSFER_NODES];
+int settled[MAX_TRANSFER_NODES];
+int parent[MAX_TRANSFER_NODES];
+int bucketHead[MAX_BUCKETS];
+int nextInBucket[MAX_TRANSFER_NODES];
+int prevInBucket[MAX_TRANSFER_NODES];
+} TransferScratch;
+// Structure for one route produced by the alternative-route generator
+typedef struct {
+int stations[MAX_PATH_LENGTH];
+int pathLength;
+int cost;
+int plateauCost;
+int overlapPercent;
+} AlternativeRoute;
+// Per-thread scratch for betweenness centrality; each worker accumulates
+// into its own centrality array and the results are summed at the end
+typedef struct {
+SearchScratch search;
+double sigma[MAX_STATIONS];
+double delta[MAX_STATIONS];
+int position[MAX_STATIONS];
+double centrality[MAX_STATIONS];
+} BrandesScratch;
+// Shared job description for the betweenness worker threads
+typedef struct {
+const NetworkVersion *net;
+int metric;
+atomic_int nextSource;
+} BetweennessJob;
+// Argument handed to each betweenness worker
+typedef struct {
+BetweennessJob *job;
+BrandesScratch *scratch;
+} BetweennessWorker;
+// Structure for one station returned by a nearest-station query
+typedef struct {
+int station;
+double distanceKm;
+} NearbyStation;
+// One instruction-set variant of the dense kernels. oneToAll writes costs
+// from source into dist (PADDED_STATIONS entries); allPairs runs blocked
+// Floyd-Warshall in place on a PADDED_STATIONS x PADDED_STATIONS matrix.
+typedef struct {
+const char *name;
+void (*oneToAll)(const int matrix[][PADDED_STATIONS], int source, int dist[]);
+void (*allPairs)(int matrix[][PADDED_STATIONS]);
+} DenseKernels;
+// Edge cost callback used only by the generic benchmark kernel
+typedef int (*EdgeCostFn)(const NetworkVersion *net, int e, const CostWeights *weights);
+// Shared job description for the many-to-many worker threads. Workers claim
+// source rows through nextSource and fill their own rows of costs.
+typedef struct {
+const NetworkVersion *net;
+const int *sources;
+int sourceCount;
+const int *targets;
+int targetCount;
+int metric;
+int *costs;
+atomic_int nextSource;
+} CostMatrixJob;
 // Union for flexible data storage
 typedef union {
 int intValue;
@@ -50,22 +285,41 @@ char stringValue[50];
 } FlexibleData;
 // ==================== GLOBAL VARIABLES ====================
 Station stations[MAX_STATIONS];
-int adjacencyMatrix[MAX_STATIONS][MAX_STATIONS];
-int fareMatrix[MAX_STATIONS][MAX_STATIONS];
-int timeMatrix[MAX_STATIONS][MAX_STATIONS];
-int crowdMatrix[MAX_STATIONS][MAX_STATIONS];
+char lineNames[MAX_LINES][30];
+int totalLines = 0;
 int visited[MAX_STATIONS];
 int totalStations = 0;
 PathInfo allPaths[MAX_ROUTES];
 int pathCount = 0;
+DenseKernels denseKernels;
+CostWeights costWeights = { WEIGHT_SCALE, WEIGHT_SCALE / 2, WEIGHT_SCALE };
+// Write-ahead journal state, guarded by networkWriteLock
+FILE *journalFile = NULL;
+long journalSequence = 0;
+long journalRecordsSinceSnapshot = 0;
+long journaledFeedOffset = 0;
+unsigned int crcTable[256];
+// Published network and epoch-based reclamation state
+_Atomic(NetworkVersion *) liveNetwork = NULL;
+atomic_ulong globalEpoch = 1;
+atomic_ulong readerEpoch[MAX_READER_THREADS];
+pthread_mutex_t networkWriteLock = PTHREAD_MUTEX_INITIALIZER;
+NetworkVersion *retiredVersions = NULL;
+// Live update feed state
+pthread_t feedThread;
+atomic_int feedRunning = 0;
+atomic_long feedRecordsApplied = 0;
+atomic_long feedRecordsRejected = 0;
+long feedOffset = 0;
 // ==================== FUNCTION PROTOTYPES ====================
 void initializeSystem();
 void setupStations();
+void setupLines();
 void setupConnections();
 void displayAllStations();
 void displayStationInfo(int stationId);
 void findAllRoutes(int source, int dest);
-void dfsExplore(int current, int dest, int path[], int pathLen,
+void dfsExplore(const NetworkVersion *net, int current, int dest, int path[], int pathLen,
 int dist, int fare, int time, int crowd);
 void rankAndDisplayRoutes(int source, int dest);
 int compareRoutesByDistance(const void *a, const void *b);
@@ -79,10 +333,109 @@ void displayMenu();
 void clearVisited();
 int getStationIndexByName(char *name);
 void displayConnectionMatrix();
-void calculateRouteMetrics(int path[], int pathLen, PathInfo *info);
+void calculateRouteMetrics(const NetworkVersion *net, int path[], int pathLen, PathInfo *info);
 void displayDetailedRoute(PathInfo *path);
 void userInteraction();
 void displayStatistics();
+const NetworkVersion *acquireNetwork(int slot);
+void releaseNetwork(int slot);
+NetworkVersion *cloneNetwork(const NetworkVersion *base);
+NetworkVersion *beginNetworkEdit();
+void commitNetworkEdit(NetworkVersion *draft);
+void abortNetworkEdit(NetworkVersion *draft);
+void reclaimRetiredVersions();
+void setConnection(NetworkVersion *net, int from, int to, int dist, int fare, int time, int crowd,
+int line);
+int applyEdgeUpdate(NetworkVersion *net, const EdgeUpdate *update);
+int parseEdgeUpdate(const char *line, EdgeUpdate *update);
+int readFeedBatch(FILE *fp, long *offset, EdgeUpdate batch[]);
+int feedRecordAllowed(const NetworkVersion *net, const EdgeUpdate *update);
+void *feedUpdaterThread(void *arg);
+void startLiveFeed();
+void stopLiveFeed();
+void toggleLiveFeed();
+void buildAdjacencyIndex(NetworkVersion *net);
+int reachableWithinBudget(const NetworkVersion *net, int source, int metric, int budget,
+SearchScratch *scratch);
+int bucketCountFor(const NetworkVersion *net, int metric, const CostWeights *weights);
+int edgeCostDistance(const NetworkVersion *net, int e, const CostWeights *weights);
+int edgeCostFare(const NetworkVersion *net, int e, const CostWeights *weights);
+int edgeCostTime(const NetworkVersion *net, int e, const CostWeights *weights);
+int edgeCostCrowd(const NetworkVersion *net, int e, const CostWeights *weights);
+int edgeCostWeighted(const NetworkVersion *net, int e, const CostWeights *weights);
+int readCostWeights();
+void findBestRouteByCost();
+void benchmarkSearchKernels();
+void initCrcTable();
+unsigned int crc32(const void *data, size_t length);
+int openJournal(const char *mode);
+int journalEdgeUpdates(const EdgeUpdate updates[], int count, long feedPosition);
+int writeSnapshot(const NetworkVersion *net, long sequence);
+int readSnapshot(NetworkVersion *draft, long *sequence, long *feedPosition);
+int compactJournal(const NetworkVersion *net);
+int replayJournal(NetworkVersion *draft, long afterSequence, long *lastSequence,
+long *feedPosition);
+int recoverNetwork();
+const char *lineName(int line);
+void fillRouteLines(const NetworkVersion *net, PathInfo *info);
+void buildTransferGraph(NetworkVersion *net);
+int transferNode(const NetworkVersion *net, int station, int line);
+int transferAwareRoute(const NetworkVersion *net, int source, int dest, int penalty,
+TransferScratch *scratch);
+void findTransferAwareRoute();
+int legCost(const NetworkVersion *net, int metric, int from, int to);
+int compareAlternativesByPlateau(const void *a, const void *b);
+int findAlternativeRoutes(const NetworkVersion *net, int source, int dest, int metric,
+SearchScratch *forward, SearchScratch *backward, AlternativeRoute routes[]);
+void displayAlternativeRoutes();
+void buildConnectivityIndex(NetworkVersion *net);
+void accumulateBetweenness(const NetworkVersion *net, int source, int metric, BrandesScratch *scratch);
+void *betweennessWorker(void *arg);
+int computeBetweenness(const NetworkVersion *net, int metric, double centrality[]);
+int findBridges(const NetworkVersion *net, int bridgeFrom[], int bridgeTo[]);
+void displayNetworkAnalytics();
+void projectCoordinates(double latitude, double longitude, double *x, double *y);
+void buildKdTree(NetworkVersion *net, int lo, int hi, int depth);
+void buildSpatialIndex(NetworkVersion *net);
+double planarDistance(const NetworkVersion *net, int station, double x, double y);
+int nearestStations(const NetworkVersion *net, double latitude, double longitude, int k,
+NearbyStation nearest[]);
+int stationsWithinRadius(const NetworkVersion *net, double latitude, double longitude,
+double radiusKm, NearbyStation found[]);
+int astarRoute(const NetworkVersion *net, int source, int dest, int metric, SearchScratch *scratch);
+void displayNearestStations();
+void findRouteFromCoordinates();
+void importStationCoordinates();
+void buildDenseMatrices(NetworkVersion *net);
+int availableDenseKernels(DenseKernels kernels[]);
+void selectDenseKernels();
+int denseAllPairs(const NetworkVersion *net, int metric, int costs[][PADDED_STATIONS]);
+void benchmarkDenseKernels();
+void batchedReachability(const NetworkVersion *net, const int sources[], int sourceCount,
+int metric, int budget, int reachCount[], int costTable[][MAX_STATIONS]);
+int readMetricChoice();
+const char *metricName(int metric);
+const char *metricUnit(int metric);
+double costInUnits(int metric, int cost);
+int costFromUnits(int metric, double value);
+void displayReachableStations();
+long elapsedMicros(struct timespec *start);
+void *costMatrixWorker(void *arg);
+int computeCostMatrix(const NetworkVersion *net, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, int costs[]);
+int readStationSet(const char *prompt, int set[]);
+int writeCostMatrixCSV(const char *fileName, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, const int costs[]);
+int writeCostMatrixBinary(const char *fileName, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, const int costs[]);
+void buildCostMatrix();
+#ifdef SELF_TEST
+void selfCheck(int passed, const char *description);
+void selfTestJournalReplay();
+void selfTestFeedReader();
+void selfTestFeedConnections();
+int runSelfTests();
+#endif
 // ==================== MAIN FUNCTION ====================
 int main() {
 int choice;
@@ -98,7 +451,13 @@ printf("========================================================================
 printf("\n");
 initializeSystem();
 setupStations();
+setupLines();
 setupConnections();
+#ifdef SELF_TEST
+return runSelfTests();
+#endif
+// Bring back edits from the last snapshot and journal, if any
+recoverNetwork();
 while(1) {
 displayMenu();
 printf("\nEnter your choice: ");
@@ -153,7 +512,44 @@ break;
 case 8:
 displayStatistics();
 break;
+case 10:
+displayReachableStations();
+break;
+case 11:
+buildCostMatrix();
+break;
+case 12:
+findBestRouteByCost();
+break;
+case 13:
+benchmarkSearchKernels();
+break;
+case 14:
+findTransferAwareRoute();
+break;
+case 15:
+displayAlternativeRoutes();
+break;
+case 16:
+displayNetworkAnalytics();
+break;
+case 17:
+displayNearestStations();
+break;
+case 18:
+findRouteFromCoordinates();
+break;
+case 19:
+importStationCoordinates();
+break;
+case 20:
+benchmarkDenseKernels();
+break;
+case 21:
+toggleLiveFeed();
+break;
 case 9:
+stopLiveFeed();
 printf("\n");
 printf("================================================================================\n");
 printf(" Thank you for using Smart Bus Navigation System!\n");
@@ -168,23 +564,17 @@ printf("\nInvalid choice! Please try again.\n");
 return 0;
 }
 void initializeSystem() {
-// Initialize all matrices with infinity/zero values
-for(int i = 0; i < MAX_STATIONS; i++) {
-for(int j = 0; j < MAX_STATIONS; j++) {
-if(i == j) {
-adjacencyMatrix[i][j] = 0;
-fareMatrix[i][j] = 0;
-timeMatrix[i][j] = 0;
-crowdMatrix[i][j] = 0;
-} else {
-adjacencyMatrix[i][j] = INFINITY_DIST;
-fareMatrix[i][j] = INFINITY_DIST;
-timeMatrix[i][j] = INFINITY_DIST;
-crowdMatrix[i][j] = 0;
-}
-}
-visited[i] = 0;
+// Publish an empty network: infinity off the diagonal, zero on it
+NetworkVersion *initial = cloneNetwork(NULL);
+initial->versionNumber = 1;
+buildAdjacencyIndex(initial);
+atomic_store(&liveNetwork, initial);
+for(int i = 0; i < MAX_READER_THREADS; i++) {
+atomic_store(&readerEpoch[i], 0);
 }
+initCrcTable();
+selectDenseKernels();
+clearVisited();
 pathCount = 0;
 }
 void setupStations() {
@@ -194,353 +584,444 @@ strcpy(stations[0].name, "Connaught Place");
 strcpy(stations[0].cardType, "Metro Card, Bus Card");
 stations[0].platform = 1;
 strcpy(stations[0].zone, "Central Delhi");
+stations[0].latitude = 28.6315;
+stations[0].longitude = 77.2167;
 // Station 1
 stations[1].id = 1;
 strcpy(stations[1].name, "India Gate");
 strcpy(stations[1].cardType, "Metro Card, Bus Card");
 stations[1].platform = 1;
 strcpy(stations[1].zone, "Central Delhi");
+stations[1].latitude = 28.6129;
+stations[1].longitude = 77.2295;
 // Station 2
 stations[2].id = 2;
 strcpy(stations[2].name, "AIIMS");
 strcpy(stations[2].cardType, "Metro Card, Bus Card");
 stations[2].platform = 2;
 strcpy(stations[2].zone, "South Delhi");
+stations[2].latitude = 28.5672;
+stations[2].longitude = 77.2100;
 // Station 3
 stations[3].id = 3;
 strcpy(stations[3].name, "Hauz Khas");
 strcpy(stations[3].cardType, "Metro Card, Bus Card");
 stations[3].platform = 2;
 strcpy(stations[3].zone, "South Delhi");
+stations[3].latitude = 28.5494;
+stations[3].longitude = 77.2001;
 // Station 4
 stations[4].id = 4;
 strcpy(stations[4].name, "Saket");
 strcpy(stations[4].cardType, "Metro Card, Bus Card");
 stations[4].platform = 1;
 strcpy(stations[4].zone, "South Delhi");
+stations[4].latitude = 28.5245;
+stations[4].longitude = 77.2066;
 // Station 5
 stations[5].id = 5;
 strcpy(stations[5].name, "Nehru Place");
 strcpy(stations[5].cardType, "Metro Card, Bus Card");
 stations[5].platform = 3;
 strcpy(stations[5].zone, "South Delhi");
+stations[5].latitude = 28.5491;
+stations[5].longitude = 77.2533;
 // Station 6
 stations[6].id = 6;
 strcpy(stations[6].name, "Kalkaji");
 strcpy(stations[6].cardType, "Metro Card, Bus Card");
 stations[6].platform = 2;
 strcpy(stations[6].zone, "South Delhi");
+stations[6].latitude = 28.5494;
+stations[6].longitude = 77.2588;
 // Station 7
 stations[7].id = 7;
 strcpy(stations[7].name, "Lajpat Nagar");
 strcpy(stations[7].cardType, "Metro Card, Bus Card");
 stations[7].platform = 2;
 strcpy(stations[7].zone, "South Delhi");
+stations[7].latitude = 28.5677;
+stations[7].longitude = 77.2433;
 // Station 8
 stations[8].id = 8;
 strcpy(stations[8].name, "Kashmere Gate");
 strcpy(stations[8].cardType, "Metro Card, Bus Card, ISBT Pass");
 stations[8].platform = 4;
 strcpy(stations[8].zone, "North Delhi");
+stations[8].latitude = 28.6675;
+stations[8].longitude = 77.2285;
 // Station 9
 stations[9].id = 9;
 strcpy(stations[9].name, "Red Fort");
 strcpy(stations[9].cardType, "Metro Card, Bus Card");
 stations[9].platform = 1;
 strcpy(stations[9].zone, "Old Delhi");
+stations[9].latitude = 28.6562;
+stations[9].longitude = 77.2410;
 // Station 10
 stations[10].id = 10;
 strcpy(stations[10].name, "Chandni Chowk");
 strcpy(stations[10].cardType, "Metro Card, Bus Card");
 stations[10].platform = 2;
 strcpy(stations[10].zone, "Old Delhi");
+stations[10].latitude = 28.6506;
+stations[10].longitude = 77.2303;
 // Station 11
 stations[11].id = 11;
 strcpy(stations[11].name, "Civil Lines");
 strcpy(stations[11].cardType, "Metro Card, Bus Card");
 stations[11].platform = 1;
 strcpy(stations[11].zone, "North Delhi");
+stations[11].latitude = 28.6769;
+stations[11].longitude = 77.2250;
 // Station 12
 stations[12].id = 12;
 strcpy(stations[12].name, "Azadpur");
 strcpy(stations[12].cardType, "Metro Card, Bus Card");
 stations[12].platform = 2;
 strcpy(stations[12].zone, "North Delhi");
+stations[12].latitude = 28.7075;
+stations[12].longitude = 77.1805;
 // Station 13
 stations[13].id = 13;
 strcpy(stations[13].name, "Pitampura");
 strcpy(stations[13].cardType, "Metro Card, Bus Card");
 stations[13].platform = 2;
 strcpy(stations[13].zone, "North West Delhi");
+stations[13].latitude = 28.7033;
+stations[13].longitude = 77.1321;
 // Station 14
 stations[14].id = 14;
 strcpy(stations[14].name, "Rohini");
 strcpy(stations[14].cardType, "Metro Card, Bus Card");
 stations[14].platform = 3;
 strcpy(stations[14].zone, "North West Delhi");
+stations[14].latitude = 28.7150;
+stations[14].longitude = 77.1150;
 // Station 15
 stations[15].id = 15;
 strcpy(stations[15].name, "Dwarka");
 strcpy(stations[15].cardType, "Metro Card, Bus Card");
 stations[15].platform = 3;
 strcpy(stations[15].zone, "South West Delhi");
+stations[15].latitude = 28.5921;
+stations[15].longitude = 77.0460;
 // Station 16
 stations[16].id = 16;
 strcpy(stations[16].name, "IGI Airport");
 strcpy(stations[16].cardType, "Metro Card, Bus Card, Airport Pass");
 stations[16].platform = 4;
 strcpy(stations[16].zone, "South West Delhi");
+stations[16].latitude = 28.5562;
+stations[16].longitude = 77.1000;
 // Station 17
 stations[17].id = 17;
 strcpy(stations[17].name, "Rajouri Garden");
 strcpy(stations[17].cardType, "Metro Card, Bus Card");
 stations[17].platform = 2;
 strcpy(stations[17].zone, "West Delhi");
+stations[17].latitude = 28.6492;
+stations[17].longitude = 77.1225;
 // Station 18
 stations[18].id = 18;
 strcpy(stations[18].name, "Janakpuri");
 strcpy(stations[18].cardType, "Metro Card, Bus Card");
 stations[18].platform = 2;
 strcpy(stations[18].zone, "West Delhi");
+stations[18].latitude = 28.6219;
+stations[18].longitude = 77.0878;
 // Station 19
 stations[19].id = 19;
 strcpy(stations[19].name, "Uttam Nagar");
 strcpy(stations[19].cardType, "Metro Card, Bus Card");
 stations[19].platform = 2;
 strcpy(stations[19].zone, "West Delhi");
+stations[19].latitude = 28.6214;
+stations[19].longitude = 77.0556;
 // Station 20
 stations[20].id = 20;
 strcpy(stations[20].name, "Noida Sector 15");
 strcpy(stations[20].cardType, "Metro Card, Bus Card");
 stations[20].platform = 2;
 strcpy(stations[20].zone, "Noida");
+stations[20].latitude = 28.5850;
+stations[20].longitude = 77.3110;
 // Station 21
 stations[21].id = 21;
 strcpy(stations[21].name, "Noida Sector 18");
 strcpy(stations[21].cardType, "Metro Card, Bus Card");
 stations[21].platform = 3;
 strcpy(stations[21].zone, "Noida");
+stations[21].latitude = 28.5707;
+stations[21].longitude = 77.3261;
 // Station 22
 stations[22].id = 22;
 strcpy(stations[22].name, "Noida Sector 62");
 strcpy(stations[22].cardType, "Metro Card, Bus Card");
 stations[22].platform = 2;
 strcpy(stations[22].zone, "Noida");
+stations[22].latitude = 28.6270;
+stations[22].longitude = 77.3650;
 // Station 23
 stations[23].id = 23;
 strcpy(stations[23].name, "Greater Noida");
 strcpy(stations[23].cardType, "Metro Card, Bus Card");
 stations[23].platform = 3;
 strcpy(stations[23].zone, "Greater Noida");
+stations[23].latitude = 28.4744;
+stations[23].longitude = 77.5040;
 // Station 24
 stations[24].id = 24;
 strcpy(stations[24].name, "Vaishali");
 strcpy(stations[24].cardType, "Metro Card, Bus Card");
 stations[24].platform = 3;
 strcpy(stations[24].zone, "Ghaziabad");
+stations[24].latitude = 28.6497;
+stations[24].longitude = 77.3397;
 // Station 25
 stations[25].id = 25;
 strcpy(stations[25].name, "Anand Vihar");
 strcpy(stations[25].cardType, "Metro Card, Bus Card, ISBT Pass");
 stations[25].platform = 4;
 strcpy(stations[25].zone, "East Delhi");
+stations[25].latitude = 28.6469;
+stations[25].longitude = 77.3159;
 // Station 26
 stations[26].id = 26;
 strcpy(stations[26].name, "Preet Vihar");
 strcpy(stations[26].cardType, "Metro Card, Bus Card");
 stations[26].platform = 2;
 strcpy(stations[26].zone, "East Delhi");
+stations[26].latitude = 28.6417;
+stations[26].longitude = 77.2950;
 // Station 27
 stations[27].id = 27;
 strcpy(stations[27].name, "Mayur Vihar");
 strcpy(stations[27].cardType, "Metro Card, Bus Card");
 stations[27].platform = 2;
 strcpy(stations[27].zone, "East Delhi");
+stations[27].latitude = 28.6040;
+stations[27].longitude = 77.2945;
 // Station 28
 stations[28].id = 28;
 strcpy(stations[28].name, "Faridabad");
 strcpy(stations[28].cardType, "Metro Card, Bus Card");
 stations[28].platform = 3;
 strcpy(stations[28].zone, "Faridabad");
+stations[28].latitude = 28.4089;
+stations[28].longitude = 77.3178;
 // Station 29
 stations[29].id = 29;
 strcpy(stations[29].name, "Gurgaon Cyber City");
 strcpy(stations[29].cardType, "Metro Card, Bus Card");
 stations[29].platform = 4;
 strcpy(stations[29].zone, "Gurgaon");
+stations[29].latitude = 28.4950;
+stations[29].longitude = 77.0895;
 // Station 30
 stations[30].id = 30;
 strcpy(stations[30].name, "MG Road Gurgaon");
 strcpy(stations[30].cardType, "Metro Card, Bus Card");
 stations[30].platform = 2;
 strcpy(stations[30].zone, "Gurgaon");
+stations[30].latitude = 28.4795;
+stations[30].longitude = 77.0803;
 // Station 31
 stations[31].id = 31;
 strcpy(stations[31].name, "Sikanderpur");
 strcpy(stations[31].cardType, "Metro Card, Bus Card");
 stations[31].platform = 2;
 strcpy(stations[31].zone, "Gurgaon");
+stations[31].latitude = 28.4815;
+stations[31].longitude = 77.0930;
 // Station 32
 stations[32].id = 32;
 strcpy(stations[32].name, "Botanical Garden");
 strcpy(stations[32].cardType, "Metro Card, Bus Card");
 stations[32].platform = 3;
 strcpy(stations[32].zone, "Noida");
+stations[32].latitude = 28.5641;
+stations[32].longitude = 77.3344;
 // Station 33
 stations[33].id = 33;
 strcpy(stations[33].name, "Karol Bagh");
 strcpy(stations[33].cardType, "Metro Card, Bus Card");
 stations[33].platform = 2;
 strcpy(stations[33].zone, "Central Delhi");
+stations[33].latitude = 28.6440;
+stations[33].longitude = 77.1888;
 // Station 34
 stations[34].id = 34;
 strcpy(stations[34].name, "Shahdara");
 strcpy(stations[34].cardType, "Metro Card, Bus Card");
 stations[34].platform = 2;
 strcpy(stations[34].zone, "East Delhi");
+stations[34].latitude = 28.6735;
+stations[34].longitude = 77.2895;
 // Station 35
 stations[35].id = 35;
 strcpy(stations[35].name, "Mundka");
 strcpy(stations[35].cardType, "Metro Card, Bus Card");
 stations[35].platform = 2;
 strcpy(stations[35].zone, "West Delhi");
+stations[35].latitude = 28.6823;
+stations[35].longitude = 77.0305;
 // Station 36
 stations[36].id = 36;
 strcpy(stations[36].name, "Badarpur");
 strcpy(stations[36].cardType, "Metro Card, Bus Card");
 stations[36].platform = 2;
 strcpy(stations[36].zone, "South Delhi");
+stations[36].latitude = 28.4934;
+stations[36].longitude = 77.3030;
 // Station 37
 stations[37].id = 37;
 strcpy(stations[37].name, "Okhla");
 strcpy(stations[37].cardType, "Metro Card, Bus Card");
 stations[37].platform = 2;
 strcpy(stations[37].zone, "South Delhi");
+stations[37].latitude = 28.5355;
+stations[37].longitude = 77.2740;
 // Station 38
 stations[38].id = 38;
 strcpy(stations[38].name, "Safdarjung");
 strcpy(stations[38].cardType, "Metro Card, Bus Card");
 stations[38].platform = 1;
 strcpy(stations[38].zone, "South Delhi");
+stations[38].latitude = 28.5646;
+stations[38].longitude = 77.1950;
 // Station 39
 stations[39].id = 39;
 strcpy(stations[39].name, "Vasant Vihar");
 strcpy(stations[39].cardType, "Metro Card, Bus Card");
 stations[39].platform = 1;
 strcpy(stations[39].zone, "South West Delhi");
+stations[39].latitude = 28.5603;
+stations[39].longitude = 77.1602;
 totalStations = 40;
 }
+void setupLines() {
+// Bus lines; every connection in setupConnections() belongs to one
+strcpy(lineNames[0], "Yellow Line");
+strcpy(lineNames[1], "Red Line");
+strcpy(lineNames[2], "Blue Line");
+strcpy(lineNames[3], "Green Line");
+strcpy(lineNames[4], "Heritage Loop");
+strcpy(lineNames[5], "Violet Line");
+strcpy(lineNames[6], "Magenta Line");
+strcpy(lineNames[7], "Aqua Line");
+strcpy(lineNames[8], "Orange Line");
+strcpy(lineNames[9], "Grey Line");
+strcpy(lineNames[10], "Feeder Line");
+strcpy(lineNames[LOCAL_LINE], "Local Connection");
+totalLines = 11;
+}
 void setupConnections() {
+NetworkVersion *draft = beginNetworkEdit();
 // Helper function to add bidirectional connection
-void addConnection(int from, int to, int dist, int fare, int time, int crowd) {
-adjacencyMatrix[from][to] = dist;
-adjacencyMatrix[to][from] = dist;
-fareMatrix[from][to] = fare;
-fareMatrix[to][from] = fare;
-timeMatrix[from][to] = time;
-timeMatrix[to][from] = time;
-crowdMatrix[from][to] = crowd;
-crowdMatrix[to][from] = crowd;
+void addConnection(int from, int to, int dist, int fare, int time, int crowd, int line) {
+setConnection(draft, from, to, dist, fare, time, crowd, line);
 }
 // Connaught Place connections
-addConnection(0, 1, 3, 10, 8, 7);
-addConnection(0, 8, 5, 15, 12, 8);
-addConnection(0, 33, 2, 8, 5, 9);
+addConnection(0, 1, 3, 10, 8, 7, 0);
+addConnection(0, 8, 5, 15, 12, 8, 1);
+addConnection(0, 33, 2, 8, 5, 9, 2);
 // India Gate connections
-addConnection(1, 2, 4, 12, 10, 6);
-addConnection(1, 9, 3, 10, 8, 7);
+addConnection(1, 2, 4, 12, 10, 6, 0);
+addConnection(1, 9, 3, 10, 8, 7, 4);
 // AIIMS connections
-addConnection(2, 3, 3, 10, 8, 7);
-addConnection(2, 38, 2, 8, 6, 5);
+addConnection(2, 3, 3, 10, 8, 7, 0);
+addConnection(2, 38, 2, 8, 6, 5, 10);
 // Hauz Khas connections
-addConnection(3, 4, 4, 12, 10, 6);
-addConnection(3, 5, 5, 15, 12, 7);
+addConnection(3, 4, 4, 12, 10, 6, 0);
+addConnection(3, 5, 5, 15, 12, 7, 5);
 // Saket connections
-addConnection(4, 39, 3, 10, 8, 5);
-addConnection(4, 5, 6, 18, 15, 6);
+addConnection(4, 39, 3, 10, 8, 5, 0);
+addConnection(4, 5, 6, 18, 15, 6, 6);
 // Nehru Place connections
-addConnection(5, 6, 3, 10, 8, 8);
-addConnection(5, 7, 2, 8, 6, 7);
+addConnection(5, 6, 3, 10, 8, 8, 6);
+addConnection(5, 7, 2, 8, 6, 7, 10);
 // Kalkaji connections
-addConnection(6, 7, 2, 8, 6, 7);
-addConnection(6, 36, 5, 15, 12, 6);
+addConnection(6, 7, 2, 8, 6, 7, 6);
+addConnection(6, 36, 5, 15, 12, 6, 10);
 // Lajpat Nagar connections
-addConnection(7, 26, 8, 20, 18, 7);
-addConnection(7, 37, 4, 12, 10, 6);
+addConnection(7, 26, 8, 20, 18, 7, 6);
+addConnection(7, 37, 4, 12, 10, 6, 10);
 // Kashmere Gate connections
-addConnection(8, 9, 2, 8, 6, 9);
-addConnection(8, 10, 3, 10, 8, 10);
-addConnection(8, 11, 3, 10, 8, 7);
+addConnection(8, 9, 2, 8, 6, 9, 4);
+addConnection(8, 10, 3, 10, 8, 10, 4);
+addConnection(8, 11, 3, 10, 8, 7, 1);
 // Red Fort connections
-addConnection(9, 10, 1, 5, 4, 9);
+addConnection(9, 10, 1, 5, 4, 9, 4);
 // Chandni Chowk connections
-addConnection(10, 11, 4, 12, 10, 8);
+addConnection(10, 11, 4, 12, 10, 8, 4);
 // Civil Lines connections
-addConnection(11, 12, 5, 15, 12, 6);
+addConnection(11, 12, 5, 15, 12, 6, 1);
 // Azadpur connections
-addConnection(12, 13, 6, 18, 15, 7);
+addConnection(12, 13, 6, 18, 15, 7, 1);
 // Pitampura connections
-addConnection(13, 14, 5, 15, 12, 6);
+addConnection(13, 14, 5, 15, 12, 6, 1);
 // Rohini connections
-addConnection(14, 35, 8, 20, 18, 5);
+addConnection(14, 35, 8, 20, 18, 5, 1);
 // Dwarka connections
-addConnection(15, 16, 4, 12, 10, 7);
-addConnection(15, 18, 6, 18, 15, 6);
+addConnection(15, 16, 4, 12, 10, 7, 2);
+addConnection(15, 18, 6, 18, 15, 6, 2);
 // IGI Airport connections
-addConnection(16, 29, 15, 50, 35, 8);
+addConnection(16, 29, 15, 50, 35, 8, 8);
 // Rajouri Garden connections
-addConnection(17, 18, 3, 10, 8, 7);
-addConnection(17, 33, 4, 12, 10, 8);
+addConnection(17, 18, 3, 10, 8, 7, 2);
+addConnection(17, 33, 4, 12, 10, 8, 2);
 // Janakpuri connections
-addConnection(18, 19, 4, 12, 10, 7);
-addConnection(18, 15, 6, 18, 15, 6);
+addConnection(18, 19, 4, 12, 10, 7, 3);
+addConnection(18, 15, 6, 18, 15, 6, 2);
 // Uttam Nagar connections
-addConnection(19, 35, 7, 20, 16, 6);
+addConnection(19, 35, 7, 20, 16, 6, 3);
 // Noida Sector 15 connections
-addConnection(20, 21, 2, 8, 6, 8);
-addConnection(20, 32, 5, 15, 12, 7);
+addConnection(20, 21, 2, 8, 6, 8, 7);
+addConnection(20, 32, 5, 15, 12, 7, 7);
 // Noida Sector 18 connections
-addConnection(21, 22, 8, 20, 18, 7);
-addConnection(21, 32, 3, 10, 8, 8);
+addConnection(21, 22, 8, 20, 18, 7, 7);
+addConnection(21, 32, 3, 10, 8, 8, 7);
 // Noida Sector 62 connections
-addConnection(22, 23, 12, 30, 25, 6);
+addConnection(22, 23, 12, 30, 25, 6, 7);
 // Vaishali connections
-addConnection(24, 25, 5, 15, 12, 7);
-addConnection(24, 27, 4, 12, 10, 7);
+addConnection(24, 25, 5, 15, 12, 7, 6);
+addConnection(24, 27, 4, 12, 10, 7, 9);
 // Anand Vihar connections
-addConnection(25, 26, 3, 10, 8, 9);
-addConnection(25, 34, 6, 18, 15, 8);
+addConnection(25, 26, 3, 10, 8, 9, 6);
+addConnection(25, 34, 6, 18, 15, 8, 9);
 // Preet Vihar connections
-addConnection(26, 27, 2, 8, 6, 8);
+addConnection(26, 27, 2, 8, 6, 8, 9);
 // Mayur Vihar connections
-addConnection(27, 32, 7, 20, 16, 7);
+addConnection(27, 32, 7, 20, 16, 7, 7);
 // Faridabad connections
-addConnection(28, 36, 10, 25, 22, 6);
-addConnection(28, 37, 8, 20, 18, 6);
+addConnection(28, 36, 10, 25, 22, 6, 5);
+addConnection(28, 37, 8, 20, 18, 6, 10);
 // Gurgaon Cyber City connections
-addConnection(29, 30, 4, 12, 10, 8);
-addConnection(29, 31, 3, 10, 8, 9);
+addConnection(29, 30, 4, 12, 10, 8, 8);
+addConnection(29, 31, 3, 10, 8, 9, 8);
 // MG Road Gurgaon connections
-addConnection(30, 31, 2, 8, 6, 8);
+addConnection(30, 31, 2, 8, 6, 8, 8);
 // Sikanderpur connections
-addConnection(31, 15, 8, 20, 18, 7);
+addConnection(31, 15, 8, 20, 18, 7, 8);
 // Botanical Garden connections
-addConnection(32, 20, 5, 15, 12, 7);
-addConnection(32, 21, 3, 10, 8, 8);
+addConnection(32, 20, 5, 15, 12, 7, 7);
+addConnection(32, 21, 3, 10, 8, 8, 7);
 // Karol Bagh connections
-addConnection(33, 17, 4, 12, 10, 8);
-addConnection(33, 8, 6, 18, 15, 9);
+addConnection(33, 17, 4, 12, 10, 8, 2);
+addConnection(33, 8, 6, 18, 15, 9, 4);
 // Shahdara connections
-addConnection(34, 25, 6, 18, 15, 8);
-addConnection(34, 10, 8, 20, 18, 8);
+addConnection(34, 25, 6, 18, 15, 8, 9);
+addConnection(34, 10, 8, 20, 18, 8, 9);
 // Badarpur connections
-addConnection(36, 37, 3, 10, 8, 6);
+addConnection(36, 37, 3, 10, 8, 6, 5);
 // Okhla connections
-addConnection(37, 5, 4, 12, 10, 6);
+addConnection(37, 5, 4, 12, 10, 6, 5);
 // Safdarjung connections
-addConnection(38, 39, 4, 12, 10, 5);
+addConnection(38, 39, 4, 12, 10, 5, 10);
 // Vasant Vihar connections
-addConnection(39, 16, 10, 25, 20, 6);
+addConnection(39, 16, 10, 25, 20, 6, 0);
+commitNetworkEdit(draft);
 }
 void displayMenu() {
 printf("\n");
@@ -554,10 +1035,22 @@ printf(" 2. Find Routes Between Stations\n");
 printf(" 3. Display Station Information\n");
 printf(" 4. Display Connection Matrix\n");
 printf(" 5. Add New Connection\n");
-printf(" 6. Save Routes to File\n");
-printf(" 7. Load Routes from File\n");
+printf(" 6. Save Routes to File (Compact Journal)\n");
+printf(" 7. Load Routes from File (Recover Journal)\n");
 printf(" 8. Display System Statistics\n");
 printf(" 9. Exit\n");
+printf(" 10. Find Reachable Stations Within Budget\n");
+printf(" 11. Build Origin-Destination Cost Matrix\n");
+printf(" 12. Find Best Route by Custom Cost\n");
+printf(" 13. Benchmark Search Kernels\n");
+printf(" 14. Find Route with Fewest Painful Transfers\n");
+printf(" 15. Find Diverse Alternative Routes\n");
+printf(" 16. Network Analytics (Hubs, Bridges, Connectivity)\n");
+printf(" 17. Find Nearest Stations to GPS Location\n");
+printf(" 18. Find Route from GPS Location\n");
+printf(" 19. Import Station Coordinates\n");
+printf(" 20. Benchmark Dense SIMD Kernels\n");
+printf(" 21. Start/Stop Live Update Feed\n");
 printf("================================================================================\n")
 ;
 }
@@ -598,22 +1091,25 @@ printf(" Station Name : %s\n", stations[stationId].name);
 printf(" Card Types : %s\n", stations[stationId].cardType);
 printf(" Platform Number : %d\n", stations[stationId].platform);
 printf(" Zone : %s\n", stations[stationId].zone);
+printf(" Location : %.4f, %.4f\n", stations[stationId].latitude, stations[stationId].longitude);
 printf("================================================================================\n")
 ;
 printf(" Connected Stations:\n");
 printf("--------------------------------------------------------------------------------\n")
 ;
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
 int connectionCount = 0;
 for(int i = 0; i < totalStations; i++) {
-if(adjacencyMatrix[stationId][i] != INFINITY_DIST && adjacencyMatrix[stationId][i] != 0) {
+if(net->adjacencyMatrix[stationId][i] != INFINITY_DIST && net->adjacencyMatrix[stationId][i] != 0) {
 printf(" -> %s (Distance: %d km, Fare: Rs %d, Time: %d min)\n",
 stations[i].name,
-adjacencyMatrix[stationId][i],
-fareMatrix[stationId][i],
-timeMatrix[stationId][i]);
+net->adjacencyMatrix[stationId][i],
+net->fareMatrix[stationId][i],
+net->timeMatrix[stationId][i]);
 connectionCount++;
 }
 }
+releaseNetwork(MAIN_READER_SLOT);
 if(connectionCount == 0) {
 printf(" No direct connections available.\n");
 }
@@ -628,14 +1124,21 @@ path[0] = source;
 visited[source] = 1;
 printf("\nSearching for routes from %s to %s...\n",
 stations[source].name, stations[dest].name);
-dfsExplore(source, dest, path, 1, 0, 0, 0, 0);
+// Pin one network version for the whole search so concurrent feed
+// updates never show a half-applied graph
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+// Stations in different components have no route; skip the DFS entirely
+if(net->componentId[source] == net->componentId[dest]) {
+dfsExplore(net, source, dest, path, 1, 0, 0, 0, 0);
+}
+releaseNetwork(MAIN_READER_SLOT);
 if(pathCount == 0) {
 printf("\nNo routes found between these stations!\n");
 } else {
 printf("\nFound %d possible route(s).\n", pathCount);
 }
 }
-void dfsExplore(int current, int dest, int path[], int pathLen,
+void dfsExplore(const NetworkVersion *net, int current, int dest, int path[], int pathLen,
 int dist, int fare, int time, int crowd) {
 if(pathCount >= MAX_ROUTES) return;
 if(current == dest) {
@@ -649,19 +1152,20 @@ newPath.totalDistance = dist;
 newPath.totalFare = fare;
 newPath.totalTime = time;
 newPath.avgCrowd = (pathLen > 1) ? crowd / (pathLen - 1) : 0;
+fillRouteLines(net, &newPath);
 allPaths[pathCount++] = newPath;
 return;
 }
 for(int i = 0; i < totalStations; i++) {
-if(!visited[i] && adjacencyMatrix[current][i] != INFINITY_DIST &&
-adjacencyMatrix[current][i] != 0 && pathLen < MAX_PATH_LENGTH) {
+if(!visited[i] && net->adjacencyMatrix[current][i] != INFINITY_DIST &&
+net->adjacencyMatrix[current][i] != 0 && pathLen < MAX_PATH_LENGTH) {
 visited[i] = 1;
 path[pathLen] = i;
-dfsExplore(i, dest, path, pathLen + 1,
-dist + adjacencyMatrix[current][i],
-fare + fareMatrix[current][i],
-time + timeMatrix[current][i],
-crowd + crowdMatrix[current][i]);
+dfsExplore(net, i, dest, path, pathLen + 1,
+dist + net->adjacencyMatrix[current][i],
+fare + net->fareMatrix[current][i],
+time + net->timeMatrix[current][i],
+crowd + net->crowdMatrix[current][i]);
 visited[i] = 0;
 }
 }
@@ -705,6 +1209,36 @@ printf("------------------------------------------------------------------------
 displayDetailedRoute(&allPaths[i]);
 }
 }
+void calculateRouteMetrics(const NetworkVersion *net, int path[], int pathLen, PathInfo *info) {
+int crowd = 0;
+info->pathLength = pathLen;
+info->totalDistance = 0;
+info->totalFare = 0;
+info->totalTime = 0;
+for(int i = 0; i < pathLen; i++) {
+info->stations[i] = path[i];
+if(i > 0) {
+info->totalDistance += net->adjacencyMatrix[path[i-1]][path[i]];
+info->totalFare += net->fareMatrix[path[i-1]][path[i]];
+info->totalTime += net->timeMatrix[path[i-1]][path[i]];
+crowd += net->crowdMatrix[path[i-1]][path[i]];
+}
+}
+info->avgCrowd = (pathLen > 1) ? crowd / (pathLen - 1) : 0;
+fillRouteLines(net, info);
+}
+// Records the line of every leg (lines[i] is the leg into stations[i]) and
+// counts the changes of line along the route
+void fillRouteLines(const NetworkVersion *net, PathInfo *info) {
+info->transfers = 0;
+info->lines[0] = -1;
+for(int i = 1; i < info->pathLength; i++) {
+info->lines[i] = net->lineMatrix[info->stations[i-1]][info->stations[i]];
+if(i > 1 && info->lines[i] != info->lines[i-1]) {
+info->transfers++;
+}
+}
+}
 void displayDetailedRoute(PathInfo *path) {
 printf(" Path: ");
 for(int i = 0; i < path->pathLength; i++) {
@@ -719,6 +1253,21 @@ printf(" Total Fare: Rs %d\n", path->totalFare);
 printf(" Total Time: %d minutes\n", path->totalTime);
 printf(" Average Crowd Level: %d/10\n", path->avgCrowd);
 printf(" Number of Stops: %d\n", path->pathLength - 1);
+printf(" Lines: ");
+for(int i = 1; i < path->pathLength; i++) {
+if(i == 1 || path->lines[i] != path->lines[i-1]) {
+printf("%s%s", i > 1 ? " -> " : "", lineName(path->lines[i]));
+}
+}
+printf("\n");
+printf(" Transfers: %d", path->transfers);
+int shown = 0;
+for(int i = 2; i < path->pathLength; i++) {
+if(path->lines[i] != path->lines[i-1]) {
+printf("%s %s", shown++ == 0 ? " at" : ",", stations[path->stations[i-1]].name);
+}
+}
+printf("\n");
 }
 int compareRoutesByDistance(const void *a, const void *b) {
 PathInfo *pathA = (PathInfo *)a;
@@ -736,34 +1285,24 @@ PathInfo *pathB = (PathInfo *)b;
 return pathA->totalTime - pathB->totalTime;
 }
 void saveRoutesToFile() {
-FILE *fp = fopen("bus_routes.dat", "wb");
-if(fp == NULL) {
+// Edits are already durable in the journal; saving folds them into a
+// fresh snapshot so the journal starts empty again
+pthread_mutex_lock(&networkWriteLock);
+long lastSequence = journalSequence;
+int saved = compactJournal(atomic_load(&liveNetwork));
+pthread_mutex_unlock(&networkWriteLock);
+if(!saved) {
 printf("\nError opening file for writing!\n");
 return;
 }
-fwrite(&totalStations, sizeof(int), 1, fp);
-fwrite(stations, sizeof(Station), totalStations, fp);
-fwrite(adjacencyMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fwrite(fareMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fwrite(timeMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fwrite(crowdMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fclose(fp);
-printf("\nRoutes saved successfully to 'bus_routes.dat'!\n");
+printf("\nRoutes saved successfully to '%s' (journal sequence %ld)!\n", SNAPSHOT_FILE, lastSequence);
 }
 void loadRoutesFromFile() {
-FILE *fp = fopen("bus_routes.dat", "rb");
-if(fp == NULL) {
+if(!recoverNetwork()) {
 printf("\nError opening file for reading! File may not exist.\n");
 return;
 }
-fread(&totalStations, sizeof(int), 1, fp);
-fread(stations, sizeof(Station), totalStations, fp);
-fread(adjacencyMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fread(fareMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fread(timeMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fread(crowdMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
-fclose(fp);
-printf("\nRoutes loaded successfully from 'bus_routes.dat'!\n");
+printf("\nRoutes loaded successfully from '%s'!\n", SNAPSHOT_FILE);
 }
 void clearVisited() {
 for(int i = 0; i < MAX_STATIONS; i++) {
@@ -790,22 +1329,24 @@ for(int i = 0; i < 10; i++) {
 printf("%4d ", i);
 }
 printf("\n");
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
 for(int i = 0; i < 10; i++) {
 printf("%4d ", i);
 for(int j = 0; j < 10; j++) {
-if(adjacencyMatrix[i][j] == INFINITY_DIST) {
+if(net->adjacencyMatrix[i][j] == INFINITY_DIST) {
 printf(" -- ");
 } else {
-printf("%4d ", adjacencyMatrix[i][j]);
+printf("%4d ", net->adjacencyMatrix[i][j]);
 }
 }
 printf("\n");
 }
+releaseNetwork(MAIN_READER_SLOT);
 printf("================================================================================\n")
 ;
 }
 void addNewConnection() {
-int from, to, dist, fare, time, crowd;
+int from, to, dist, fare, time, crowd, line;
 printf("\n");
 printf("================================================================================\n")
 ;
@@ -832,37 +1373,55 @@ printf("Enter travel time (minutes): ");
 scanf("%d", &time);
 printf("Enter crowd level (0-10): ");
 scanf("%d", &crowd);
-adjacencyMatrix[from][to] = dist;
-adjacencyMatrix[to][from] = dist;
-fareMatrix[from][to] = fare;
-fareMatrix[to][from] = fare;
-timeMatrix[from][to] = time;
-timeMatrix[to][from] = time;
-crowdMatrix[from][to] = crowd;
-crowdMatrix[to][from] = crowd;
+printf("Enter line ID (0-%d, or %d for a local connection): ", totalLines-1, LOCAL_LINE);
+scanf("%d", &line);
+EdgeUpdate updates[5] = {
+{ from, to, FIELD_DISTANCE, dist },
+{ from, to, FIELD_FARE, fare },
+{ from, to, FIELD_TIME, time },
+{ from, to, FIELD_CROWD, crowd },
+{ from, to, FIELD_LINE, line }
+};
+NetworkVersion *draft = beginNetworkEdit();
+for(int i = 0; i < 5; i++) {
+if(!applyEdgeUpdate(draft, &updates[i])) {
+// Nothing was published or journaled; drop the draft
+abortNetworkEdit(draft);
+printf("\nInvalid connection values!\n");
+return;
+}
+}
+if(!journalEdgeUpdates(updates, 5, -1)) {
+printf("\nWarning: could not write '%s'; this edit is not durable.\n", JOURNAL_FILE);
+}
+commitNetworkEdit(draft);
 printf("\nConnection added successfully!\n");
 printf(" %s <-> %s\n", stations[from].name, stations[to].name);
-printf(" Distance: %d km, Fare: Rs %d, Time: %d min\n", dist, fare, time);
+printf(" Distance: %d km, Fare: Rs %d, Time: %d min, Line: %s\n", dist, fare, time, lineName(line));
 }
 void displayStatistics() {
 int totalConnections = 0;
 int totalDistance = 0;
 int maxDistance = 0;
 int minDistance = INFINITY_DIST;
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+long versionNumber = net->versionNumber;
+int componentCount = net->componentCount;
 for(int i = 0; i < totalStations; i++) {
 for(int j = i+1; j < totalStations; j++) {
-if(adjacencyMatrix[i][j] != INFINITY_DIST && adjacencyMatrix[i][j] != 0) {
+if(net->adjacencyMatrix[i][j] != INFINITY_DIST && net->adjacencyMatrix[i][j] != 0) {
 totalConnections++;
-totalDistance += adjacencyMatrix[i][j];
-if(adjacencyMatrix[i][j] > maxDistance) {
-maxDistance = adjacencyMatrix[i][j];
+totalDistance += net->adjacencyMatrix[i][j];
+if(net->adjacencyMatrix[i][j] > maxDistance) {
+maxDistance = net->adjacencyMatrix[i][j];
 }
-if(adjacencyMatrix[i][j] < minDistance) {
-minDistance = adjacencyMatrix[i][j];
+if(net->adjacencyMatrix[i][j] < minDistance) {
+minDistance = net->adjacencyMatrix[i][j];
 }
 }
 }
 }
+releaseNetwork(MAIN_READER_SLOT);
 printf("\n");
 printf("================================================================================\n")
 ;
@@ -871,13 +1430,2647 @@ printf("========================================================================
 ;
 printf(" Total Stations : %d\n", totalStations);
 printf(" Total Connections : %d\n", totalConnections);
+printf(" Connected Components : %d\n", componentCount);
 printf(" Average Distance : %d km\n",
 totalConnections > 0 ? totalDistance / totalConnections : 0);
 printf(" Maximum Distance : %d km\n", maxDistance);
 printf(" Minimum Distance : %d km\n",
 minDistance == INFINITY_DIST ? 0 : minDistance);
+printf(" Network Version : %ld\n", versionNumber);
+printf(" Journal Sequence : %ld (%ld since last snapshot)\n",
+journalSequence, journalRecordsSinceSnapshot);
+printf(" Live Feed : %s (%ld applied, %ld rejected)\n",
+atomic_load(&feedRunning) ? "Running" : "Stopped",
+atomic_load(&feedRecordsApplied), atomic_load(&feedRecordsRejected));
 printf(" Network Coverage : Delhi NCR\n");
 printf(" Supported Card Types : Metro Card, Bus Card, ISBT Pass, Airport Pass\n");
 printf("================================================================================\n")
 ;
 }
+// ==================== NETWORK VERSIONS ====================
+// Queries pin the current version by announcing the global epoch in their
+// reader slot, then load liveNetwork. Writers are serialized by
+// networkWriteLock, swap in a new version and free an old one only when
+// every active reader announced an epoch at or after its retirement.
+const NetworkVersion *acquireNetwork(int slot) {
+atomic_store(&readerEpoch[slot], atomic_load(&globalEpoch));
+return atomic_load(&liveNetwork);
+}
+void releaseNetwork(int slot) {
+atomic_store(&readerEpoch[slot], 0);
+}
+NetworkVersion *cloneNetwork(const NetworkVersion *base) {
+// Aligned so the dense matrix rows can be loaded as whole vectors
+NetworkVersion *net = NULL;
+if(posix_memalign((void **)&net, DENSE_ALIGNMENT, sizeof(NetworkVersion)) != 0) {
+net = NULL;
+}
+if(net == NULL) {
+printf("\nOut of memory while building network version!\n");
+exit(1);
+}
+if(base != NULL) {
+memcpy(net, base, sizeof(NetworkVersion));
+} else {
+net->versionNumber = 0;
+for(int i = 0; i < MAX_STATIONS; i++) {
+for(int j = 0; j < MAX_STATIONS; j++) {
+net->adjacencyMatrix[i][j] = (i == j) ? 0 : INFINITY_DIST;
+net->fareMatrix[i][j] = (i == j) ? 0 : INFINITY_DIST;
+net->timeMatrix[i][j] = (i == j) ? 0 : INFINITY_DIST;
+net->crowdMatrix[i][j] = 0;
+net->lineMatrix[i][j] = LOCAL_LINE;
+}
+}
+}
+net->retireEpoch = 0;
+net->nextRetired = NULL;
+return net;
+}
+NetworkVersion *beginNetworkEdit() {
+pthread_mutex_lock(&networkWriteLock);
+return cloneNetwork(atomic_load(&liveNetwork));
+}
+void commitNetworkEdit(NetworkVersion *draft) {
+NetworkVersion *old = atomic_load(&liveNetwork);
+draft->versionNumber = old->versionNumber + 1;
+buildAdjacencyIndex(draft);
+atomic_exchange(&liveNetwork, draft);
+// Readers that can still see the old version announced an epoch below this one
+old->retireEpoch = atomic_fetch_add(&globalEpoch, 1) + 1;
+old->nextRetired = retiredVersions;
+retiredVersions = old;
+reclaimRetiredVersions();
+if(journalRecordsSinceSnapshot >= JOURNAL_COMPACT_THRESHOLD) {
+compactJournal(draft);
+}
+pthread_mutex_unlock(&networkWriteLock);
+}
+// Drops a draft from beginNetworkEdit without publishing it
+void abortNetworkEdit(NetworkVersion *draft) {
+free(draft);
+pthread_mutex_unlock(&networkWriteLock);
+}
+void reclaimRetiredVersions() {
+unsigned long oldestActive = ULONG_MAX;
+for(int i = 0; i < MAX_READER_THREADS; i++) {
+unsigned long epoch = atomic_load(&readerEpoch[i]);
+if(epoch != 0 && epoch < oldestActive) {
+oldestActive = epoch;
+}
+}
+NetworkVersion **link = &retiredVersions;
+while(*link != NULL) {
+NetworkVersion *version = *link;
+if(version->retireEpoch <= oldestActive) {
+*link = version->nextRetired;
+free(version);
+} else {
+link = &version->nextRetired;
+}
+}
+}
+void setConnection(NetworkVersion *net, int from, int to, int dist, int fare, int time, int crowd,
+int line) {
+net->adjacencyMatrix[from][to] = dist;
+net->adjacencyMatrix[to][from] = dist;
+net->fareMatrix[from][to] = fare;
+net->fareMatrix[to][from] = fare;
+net->timeMatrix[from][to] = time;
+net->timeMatrix[to][from] = time;
+net->crowdMatrix[from][to] = crowd;
+net->crowdMatrix[to][from] = crowd;
+net->lineMatrix[from][to] = line;
+net->lineMatrix[to][from] = line;
+}
+// ==================== LIVE UPDATE FEED ====================
+// Feed records are text lines "<from> <to> <field> <value>" appended to
+// FEED_FILE, where field is distance, fare, time, crowd or line. Connections stay
+// bidirectional, so a record updates both directions.
+int applyEdgeUpdate(NetworkVersion *net, const EdgeUpdate *update) {
+int from = update->from;
+int to = update->to;
+if(from < 0 || from >= totalStations || to < 0 || to >= totalStations || from == to) {
+return 0;
+}
+if(update->value < 0) {
+return 0;
+}
+switch(update->field) {
+case FIELD_DISTANCE:
+if(update->value == 0 || update->value > INFINITY_DIST) return 0;
+net->adjacencyMatrix[from][to] = update->value;
+net->adjacencyMatrix[to][from] = update->value;
+break;
+case FIELD_FARE:
+if(update->value > INFINITY_DIST) return 0;
+net->fareMatrix[from][to] = update->value;
+net->fareMatrix[to][from] = update->value;
+break;
+case FIELD_TIME:
+if(update->value > INFINITY_DIST) return 0;
+net->timeMatrix[from][to] = update->value;
+net->timeMatrix[to][from] = update->value;
+break;
+case FIELD_CROWD:
+if(update->value > 10) return 0;
+net->crowdMatrix[from][to] = update->value;
+net->crowdMatrix[to][from] = update->value;
+break;
+case FIELD_LINE:
+if(update->value >= totalLines && update->value != LOCAL_LINE) return 0;
+net->lineMatrix[from][to] = update->value;
+net->lineMatrix[to][from] = update->value;
+break;
+default:
+return 0;
+}
+return 1;
+}
+int parseEdgeUpdate(const char *line, EdgeUpdate *update) {
+char fieldName[20];
+if(sscanf(line, "%d %d %19s %d", &update->from, &update->to, fieldName, &update->value) != 4) {
+return 0;
+}
+if(strcasecmp(fieldName, "distance") == 0) {
+update->field = FIELD_DISTANCE;
+} else if(strcasecmp(fieldName, "fare") == 0) {
+update->field = FIELD_FARE;
+} else if(strcasecmp(fieldName, "time") == 0) {
+update->field = FIELD_TIME;
+} else if(strcasecmp(fieldName, "crowd") == 0) {
+update->field = FIELD_CROWD;
+} else if(strcasecmp(fieldName, "line") == 0) {
+update->field = FIELD_LINE;
+} else {
+return 0;
+}
+return 1;
+}
+// Reads up to MAX_FEED_BATCH records from *offset, advancing it past every
+// complete line. A line too long for the buffer is skipped and counted as
+// rejected; a line still missing its newline at EOF is left for the next
+// poll. Returns the number of records parsed into batch.
+int readFeedBatch(FILE *fp, long *offset, EdgeUpdate batch[]) {
+char line[128];
+int batchSize = 0;
+if(fseek(fp, *offset, SEEK_SET) != 0) {
+return 0;
+}
+while(batchSize < MAX_FEED_BATCH && fgets(line, sizeof(line), fp) != NULL) {
+if(strchr(line, '\n') == NULL) {
+if(strlen(line) < sizeof(line) - 1) break;
+int c;
+while((c = fgetc(fp)) != EOF && c != '\n');
+if(c == EOF) break;
+*offset = ftell(fp);
+atomic_fetch_add(&feedRecordsRejected, 1);
+continue;
+}
+*offset = ftell(fp);
+if(parseEdgeUpdate(line, &batch[batchSize])) {
+batchSize++;
+} else if(line[0] != '\n' && line[0] != '#') {
+atomic_fetch_add(&feedRecordsRejected, 1);
+}
+}
+return batchSize;
+}
+// Feed records only change existing connections. A new one needs all its
+// fields at once (menu option 5); created from a single field it would keep
+// INFINITY_DIST for the rest, and that maximum edge weight would push the
+// weighted search past MAX_BUCKETS.
+int feedRecordAllowed(const NetworkVersion *net, const EdgeUpdate *update) {
+if(update->from < 0 || update->from >= totalStations || update->to < 0 || update->to >= totalStations) {
+return 0;
+}
+int dist = net->adjacencyMatrix[update->from][update->to];
+return dist != 0 && dist != INFINITY_DIST;
+}
+void *feedUpdaterThread(void *arg) {
+(void)arg;
+EdgeUpdate batch[MAX_FEED_BATCH];
+struct timespec pause = { 0, FEED_POLL_MS * 1000000L };
+while(atomic_load(&feedRunning)) {
+int batchSize = 0;
+FILE *fp = fopen(FEED_FILE, "r");
+// A feed file shorter than what we have read was rotated; start it over
+if(fp != NULL && fseek(fp, 0, SEEK_END) == 0 && ftell(fp) < feedOffset) {
+feedOffset = 0;
+}
+if(fp != NULL) {
+batchSize = readFeedBatch(fp, &feedOffset, batch);
+fclose(fp);
+}
+if(batchSize > 0) {
+// The whole batch becomes visible to queries in one swap
+NetworkVersion *draft = beginNetworkEdit();
+int accepted = 0;
+for(int i = 0; i < batchSize; i++) {
+if(feedRecordAllowed(draft, &batch[i]) && applyEdgeUpdate(draft, &batch[i])) {
+batch[accepted++] = batch[i];
+} else {
+atomic_fetch_add(&feedRecordsRejected, 1);
+}
+}
+if(accepted == 0) {
+// Nothing in the batch changed the network; don't publish a version
+abortNetworkEdit(draft);
+} else {
+journalEdgeUpdates(batch, accepted, feedOffset);
+atomic_fetch_add(&feedRecordsApplied, accepted);
+commitNetworkEdit(draft);
+}
+}
+if(batchSize < MAX_FEED_BATCH) {
+nanosleep(&pause, NULL);
+}
+}
+return NULL;
+}
+void startLiveFeed() {
+if(atomic_load(&feedRunning)) return;
+// Resume after the last batch that reached the journal, so records applied
+// before a restart are not applied again over newer edits
+pthread_mutex_lock(&networkWriteLock);
+feedOffset = journaledFeedOffset;
+pthread_mutex_unlock(&networkWriteLock);
+atomic_store(&feedRunning, 1);
+if(pthread_create(&feedThread, NULL, feedUpdaterThread, NULL) != 0) {
+atomic_store(&feedRunning, 0);
+printf("\nError starting live update feed!\n");
+}
+}
+void stopLiveFeed() {
+if(!atomic_load(&feedRunning)) return;
+atomic_store(&feedRunning, 0);
+pthread_join(feedThread, NULL);
+}
+void toggleLiveFeed() {
+printf("\n");
+printf("================================================================================\n");
+printf(" LIVE UPDATE FEED\n");
+printf("================================================================================\n");
+if(atomic_load(&feedRunning)) {
+stopLiveFeed();
+printf(" Feed stopped.\n");
+} else {
+startLiveFeed();
+if(atomic_load(&feedRunning)) {
+printf(" Feed started, watching '%s'.\n", FEED_FILE);
+printf(" Record format: <from id> <to id> <distance|fare|time|crowd|line> <value>\n");
+}
+}
+printf(" Records applied : %ld\n", atomic_load(&feedRecordsApplied));
+printf(" Records rejected : %ld\n", atomic_load(&feedRecordsRejected));
+printf("================================================================================\n");
+}
+// ==================== REACHABILITY QUERIES ====================
+void buildAdjacencyIndex(NetworkVersion *net) {
+int e = 0;
+for(int m = 0; m < STORED_METRICS; m++) {
+net->maxEdgeWeight[m] = 0;
+}
+for(int i = 0; i < MAX_STATIONS; i++) {
+net->edgeStart[i] = e;
+for(int j = 0; j < MAX_STATIONS; j++) {
+if(i == j || net->adjacencyMatrix[i][j] == INFINITY_DIST || net->adjacencyMatrix[i][j] == 0) {
+continue;
+}
+net->edgeTarget[e] = j;
+net->edgeWeight[METRIC_DISTANCE][e] = net->adjacencyMatrix[i][j];
+net->edgeWeight[METRIC_FARE][e] = net->fareMatrix[i][j];
+net->edgeWeight[METRIC_TIME][e] = net->timeMatrix[i][j];
+net->edgeWeight[METRIC_CROWD][e] = net->crowdMatrix[i][j];
+for(int m = 0; m < STORED_METRICS; m++) {
+if(net->edgeWeight[m][e] > net->maxEdgeWeight[m]) {
+net->maxEdgeWeight[m] = net->edgeWeight[m][e];
+}
+}
+e++;
+}
+}
+net->edgeStart[MAX_STATIONS] = e;
+net->edgeCount = e;
+buildTransferGraph(net);
+buildConnectivityIndex(net);
+buildSpatialIndex(net);
+buildDenseMatrices(net);
+}
+// Dial's algorithm: every queued station has a cost within one maximum edge
+// weight of the cursor, so a ring of maxEdgeWeight+1 buckets never collides
+// and stations are settled in non-decreasing cost order. The kernel is
+// stamped out once per metric so EDGE_COST is inlined into the relaxation
+// loop; only bucketSearchGeneric pays for an indirect call per edge.
+#define DEFINE_BUCKET_SEARCH(kernelName, EDGE_COST) \
+static int kernelName(const NetworkVersion *net, int source, int budget, \
+const CostWeights *weights, EdgeCostFn edgeCost, int bucketCount, SearchScratch *scratch) { \
+(void)weights; \
+(void)edgeCost; \
+for(int i = 0; i < totalStations; i++) { \
+scratch->cost[i] = INT_MAX; \
+scratch->settled[i] = 0; \
+} \
+for(int b = 0; b < bucketCount; b++) { \
+scratch->bucketHead[b] = -1; \
+} \
+scratch->reachedCount = 0; \
+scratch->cost[source] = 0; \
+scratch->parent[source] = -1; \
+scratch->bucketHead[0] = source; \
+scratch->nextInBucket[source] = -1; \
+scratch->prevInBucket[source] = -1; \
+int queued = 1; \
+int cursor = 0; \
+while(queued > 0 && cursor <= budget) { \
+int b = cursor % bucketCount; \
+int u = scratch->bucketHead[b]; \
+if(u == -1) { \
+cursor++; \
+continue; \
+} \
+scratch->bucketHead[b] = scratch->nextInBucket[u]; \
+if(scratch->bucketHead[b] != -1) { \
+scratch->prevInBucket[scratch->bucketHead[b]] = -1; \
+} \
+queued--; \
+scratch->settled[u] = 1; \
+scratch->order[scratch->reachedCount++] = u; \
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) { \
+int v = net->edgeTarget[e]; \
+int newCost = cursor + (EDGE_COST); \
+if(v >= totalStations || scratch->settled[v] || newCost > budget || \
+newCost >= scratch->cost[v]) { \
+continue; \
+} \
+if(scratch->cost[v] == INT_MAX) { \
+queued++; \
+} else { \
+int oldBucket = scratch->cost[v] % bucketCount; \
+if(scratch->prevInBucket[v] != -1) { \
+scratch->nextInBucket[scratch->prevInBucket[v]] = scratch->nextInBucket[v]; \
+} else { \
+scratch->bucketHead[oldBucket] = scratch->nextInBucket[v]; \
+} \
+if(scratch->nextInBucket[v] != -1) { \
+scratch->prevInBucket[scratch->nextInBucket[v]] = scratch->prevInBucket[v]; \
+} \
+} \
+int newBucket = newCost % bucketCount; \
+scratch->cost[v] = newCost; \
+scratch->parent[v] = u; \
+scratch->prevInBucket[v] = -1; \
+scratch->nextInBucket[v] = scratch->bucketHead[newBucket]; \
+if(scratch->bucketHead[newBucket] != -1) { \
+scratch->prevInBucket[scratch->bucketHead[newBucket]] = v; \
+} \
+scratch->bucketHead[newBucket] = v; \
+} \
+} \
+return scratch->reachedCount; \
+}
+static int bucketSearchGeneric(const NetworkVersion *net, int source, int budget,
+const CostWeights *weights, EdgeCostFn edgeCost, int bucketCount, SearchScratch *scratch)
+__attribute__((noinline, noclone));
+DEFINE_BUCKET_SEARCH(bucketSearchDistance, net->edgeWeight[METRIC_DISTANCE][e])
+DEFINE_BUCKET_SEARCH(bucketSearchFare, net->edgeWeight[METRIC_FARE][e])
+DEFINE_BUCKET_SEARCH(bucketSearchTime, net->edgeWeight[METRIC_TIME][e])
+DEFINE_BUCKET_SEARCH(bucketSearchCrowd, net->edgeWeight[METRIC_CROWD][e])
+DEFINE_BUCKET_SEARCH(bucketSearchWeighted,
+weights->timeWeight * net->edgeWeight[METRIC_TIME][e] +
+weights->fareWeight * net->edgeWeight[METRIC_FARE][e] +
+weights->crowdWeight * net->edgeWeight[METRIC_CROWD][e])
+DEFINE_BUCKET_SEARCH(bucketSearchGeneric, edgeCost(net, e, weights))
+int edgeCostDistance(const NetworkVersion *net, int e, const CostWeights *weights) {
+(void)weights;
+return net->edgeWeight[METRIC_DISTANCE][e];
+}
+int edgeCostFare(const NetworkVersion *net, int e, const CostWeights *weights) {
+(void)weights;
+return net->edgeWeight[METRIC_FARE][e];
+}
+int edgeCostTime(const NetworkVersion *net, int e, const CostWeights *weights) {
+(void)weights;
+return net->edgeWeight[METRIC_TIME][e];
+}
+int edgeCostCrowd(const NetworkVersion *net, int e, const CostWeights *weights) {
+(void)weights;
+return net->edgeWeight[METRIC_CROWD][e];
+}
+int edgeCostWeighted(const NetworkVersion *net, int e, const CostWeights *weights) {
+return weights->timeWeight * net->edgeWeight[METRIC_TIME][e] +
+weights->fareWeight * net->edgeWeight[METRIC_FARE][e] +
+weights->crowdWeight * net->edgeWeight[METRIC_CROWD][e];
+}
+EdgeCostFn edgeCostFunctions[METRIC_COUNT] = {
+edgeCostDistance, edgeCostFare, edgeCostTime, edgeCostCrowd, edgeCostWeighted
+};
+// Ring size for the bucket queue: one more than the largest edge cost. For
+// the weighted cost the per-metric maxima give a safe upper bound.
+int bucketCountFor(const NetworkVersion *net, int metric, const CostWeights *weights) {
+if(metric != METRIC_WEIGHTED) {
+return net->maxEdgeWeight[metric] + 1;
+}
+long bound = (long)weights->timeWeight * net->maxEdgeWeight[METRIC_TIME] +
+(long)weights->fareWeight * net->maxEdgeWeight[METRIC_FARE] +
+(long)weights->crowdWeight * net->maxEdgeWeight[METRIC_CROWD] + 1;
+return bound > MAX_BUCKETS ? MAX_BUCKETS + 1 : (int)bound;
+}
+// Returns the number of stations within budget (scratch->order lists them
+// cheapest first), or -1 if the metric's edge costs overflow the bucket ring.
+int reachableWithinBudget(const NetworkVersion *net, int source, int metric, int budget,
+SearchScratch *scratch) {
+int bucketCount = bucketCountFor(net, metric, &costWeights);
+if(bucketCount > MAX_BUCKETS) {
+scratch->reachedCount = 0;
+return -1;
+}
+switch(metric) {
+case METRIC_DISTANCE:
+return bucketSearchDistance(net, source, budget, &costWeights, NULL, bucketCount, scratch);
+case METRIC_FARE:
+return bucketSearchFare(net, source, budget, &costWeights, NULL, bucketCount, scratch);
+case METRIC_TIME:
+return bucketSearchTime(net, source, budget, &costWeights, NULL, bucketCount, scratch);
+case METRIC_CROWD:
+return bucketSearchCrowd(net, source, budget, &costWeights, NULL, bucketCount, scratch);
+default:
+return bucketSearchWeighted(net, source, budget, &costWeights, NULL, bucketCount, scratch);
+}
+}
+// Runs the one-to-all query from each source with a single shared scratch.
+// costTable rows hold INFINITY_DIST for stations outside the budget.
+void batchedReachability(const NetworkVersion *net, const int sources[], int sourceCount,
+int metric, int budget, int reachCount[], int costTable[][MAX_STATIONS]) {
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+for(int s = 0; s < sourceCount; s++) {
+reachCount[s] = reachableWithinBudget(net, sources[s], metric, budget, scratch);
+if(costTable != NULL) {
+for(int i = 0; i < totalStations; i++) {
+costTable[s][i] = (reachCount[s] > 0 && scratch->settled[i]) ? scratch->cost[i] : INFINITY_DIST;
+}
+}
+}
+free(scratch);
+}
+int readMetricChoice() {
+int choice;
+printf("Select metric (1. Distance 2. Fare 3. Time 4. Crowd 5. Weighted): ");
+scanf("%d", &choice);
+if(choice < 1 || choice > METRIC_COUNT) {
+return -1;
+}
+if(choice - 1 == METRIC_WEIGHTED && !readCostWeights()) {
+return -1;
+}
+return choice - 1;
+}
+const char *metricName(int metric) {
+switch(metric) {
+case METRIC_DISTANCE: return "Distance";
+case METRIC_FARE: return "Fare";
+case METRIC_TIME: return "Time";
+case METRIC_CROWD: return "Crowd";
+case METRIC_WEIGHTED: return "Weighted Cost";
+default: return "Unknown";
+}
+}
+const char *metricUnit(int metric) {
+switch(metric) {
+case METRIC_DISTANCE: return "km";
+case METRIC_FARE: return "Rs";
+case METRIC_TIME: return "min";
+case METRIC_CROWD: return "crowd pts";
+case METRIC_WEIGHTED: return "cost pts";
+default: return "";
+}
+}
+// Searches keep weighted costs in 1/WEIGHT_SCALE points so they stay integer;
+// these convert between search costs and the units shown by metricUnit
+double costInUnits(int metric, int cost) {
+return (metric == METRIC_WEIGHTED) ? (double)cost / WEIGHT_SCALE : cost;
+}
+int costFromUnits(int metric, double value) {
+return (metric == METRIC_WEIGHTED) ? (int)(value * WEIGHT_SCALE + 0.5) : (int)value;
+}
+long elapsedMicros(struct timespec *start) {
+struct timespec now;
+clock_gettime(CLOCK_MONOTONIC, &now);
+return (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+void displayReachableStations() {
+char sourceName[50];
+double budgetValue;
+printf("\n");
+printf("================================================================================\n");
+printf(" REACHABLE STATIONS WITHIN BUDGET\n");
+printf("================================================================================\n");
+printf("Enter source station name (or ALL for a coverage map): ");
+scanf(" %[^\n]", sourceName);
+int source = -1;
+if(strcasecmp(sourceName, "ALL") != 0) {
+source = getStationIndexByName(sourceName);
+if(source == -1) {
+printf("\nSource station not found!\n");
+return;
+}
+}
+int metric = readMetricChoice();
+if(metric == -1) {
+printf("\nInvalid metric!\n");
+return;
+}
+printf("Enter budget (%s): ", metricUnit(metric));
+scanf("%lf", &budgetValue);
+if(budgetValue < 0 || budgetValue > INT_MAX / WEIGHT_SCALE) {
+printf("\nInvalid budget!\n");
+return;
+}
+int budget = costFromUnits(metric, budgetValue);
+struct timespec start;
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(bucketCountFor(net, metric, &costWeights) > MAX_BUCKETS) {
+releaseNetwork(MAIN_READER_SLOT);
+printf("\nWeighted edge costs are too large for the bucket queue; lower the weights.\n");
+return;
+}
+if(source != -1) {
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+releaseNetwork(MAIN_READER_SLOT);
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+clock_gettime(CLOCK_MONOTONIC, &start);
+int count = reachableWithinBudget(net, source, metric, budget, scratch);
+long micros = elapsedMicros(&start);
+printf("\n %d station(s) reachable from %s within %g %s (%ld us):\n",
+count, stations[source].name, costInUnits(metric, budget), metricUnit(metric), micros);
+printf("--------------------------------------------------------------------------------\n");
+for(int i = 0; i < count; i++) {
+int station = scratch->order[i];
+printf(" %-25s %s: %g %s\n", stations[station].name, metricName(metric),
+costInUnits(metric, scratch->cost[station]), metricUnit(metric));
+}
+free(scratch);
+} else {
+int sources[MAX_STATIONS];
+int reachCount[MAX_STATIONS];
+for(int i = 0; i < totalStations; i++) {
+sources[i] = i;
+}
+clock_gettime(CLOCK_MONOTONIC, &start);
+batchedReachability(net, sources, totalStations, metric, budget, reachCount, NULL);
+long micros = elapsedMicros(&start);
+printf("\n Coverage within %g %s for all %d stations (%ld us):\n",
+costInUnits(metric, budget), metricUnit(metric), totalStations, micros);
+printf("--------------------------------------------------------------------------------\n");
+for(int i = 0; i < totalStations; i++) {
+printf(" %-25s %d station(s)\n", stations[i].name, reachCount[i]);
+}
+}
+releaseNetwork(MAIN_READER_SLOT);
+printf("================================================================================\n");
+}
+// ==================== MANY-TO-MANY COST MATRIX ====================
+void *costMatrixWorker(void *arg) {
+CostMatrixJob *job = (CostMatrixJob *)arg;
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+return NULL;
+}
+int row;
+while((row = atomic_fetch_add(&job->nextSource, 1)) < job->sourceCount) {
+int reached = reachableWithinBudget(job->net, job->sources[row], job->metric, INT_MAX, scratch);
+int *out = job->costs + (long)row * job->targetCount;
+for(int t = 0; t < job->targetCount; t++) {
+int target = job->targets[t];
+out[t] = (reached > 0 && scratch->settled[target]) ? scratch->cost[target] : INFINITY_DIST;
+}
+}
+free(scratch);
+return NULL;
+}
+// Fills costs[s * targetCount + t] with the cheapest cost from sources[s] to
+// targets[t], one single-source search per source row spread over all cores.
+// The caller keeps net pinned until this returns. Returns the thread count.
+int computeCostMatrix(const NetworkVersion *net, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, int costs[]) {
+CostMatrixJob job;
+job.net = net;
+job.sources = sources;
+job.sourceCount = sourceCount;
+job.targets = targets;
+job.targetCount = targetCount;
+job.metric = metric;
+job.costs = costs;
+atomic_init(&job.nextSource, 0);
+long cores = sysconf(_SC_NPROCESSORS_ONLN);
+int threadCount = (cores < 1) ? 1 : (cores > MAX_READER_THREADS ? MAX_READER_THREADS : (int)cores);
+if(threadCount > sourceCount) {
+threadCount = sourceCount > 0 ? sourceCount : 1;
+}
+pthread_t workers[MAX_READER_THREADS];
+int started = 0;
+for(int i = 1; i < threadCount; i++) {
+if(pthread_create(&workers[started], NULL, costMatrixWorker, &job) == 0) {
+started++;
+}
+}
+// The calling thread works too, so rows are always finished even if no
+// extra thread could be started
+costMatrixWorker(&job);
+for(int i = 0; i < started; i++) {
+pthread_join(workers[i], NULL);
+}
+return started + 1;
+}
+// Reads a line of station IDs ("ALL" for every station) into set.
+// Returns the number of IDs read, or -1 on an invalid ID.
+int readStationSet(const char *prompt, int set[]) {
+char line[512];
+printf("%s", prompt);
+scanf(" %511[^\n]", line);
+if(strcasecmp(line, "ALL") == 0) {
+for(int i = 0; i < totalStations; i++) {
+set[i] = i;
+}
+return totalStations;
+}
+int count = 0;
+char *token = strtok(line, " ,");
+while(token != NULL && count < MAX_STATIONS) {
+char *end;
+long id = strtol(token, &end, 10);
+if(*end != '\0' || id < 0 || id >= totalStations) {
+return -1;
+}
+set[count++] = (int)id;
+token = strtok(NULL, " ,");
+}
+return count;
+}
+int writeCostMatrixCSV(const char *fileName, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, const int costs[]) {
+FILE *fp = fopen(fileName, "w");
+if(fp == NULL) {
+return 0;
+}
+fprintf(fp, "source");
+for(int t = 0; t < targetCount; t++) {
+fprintf(fp, ",%s", stations[targets[t]].name);
+}
+fprintf(fp, "\n");
+for(int s = 0; s < sourceCount; s++) {
+fprintf(fp, "%s", stations[sources[s]].name);
+for(int t = 0; t < targetCount; t++) {
+int cost = costs[(long)s * targetCount + t];
+if(cost == INFINITY_DIST) {
+fprintf(fp, ",%d", cost);
+} else {
+fprintf(fp, ",%g", costInUnits(metric, cost));
+}
+}
+fprintf(fp, "\n");
+}
+fclose(fp);
+return 1;
+}
+// Binary layout: sourceCount, targetCount, metric, source IDs, target IDs,
+// then the row-major cost matrix, all as native ints. Weighted costs stay in
+// 1/WEIGHT_SCALE points.
+int writeCostMatrixBinary(const char *fileName, const int sources[], int sourceCount,
+const int targets[], int targetCount, int metric, const int costs[]) {
+FILE *fp = fopen(fileName, "wb");
+if(fp == NULL) {
+return 0;
+}
+fwrite(&sourceCount, sizeof(int), 1, fp);
+fwrite(&targetCount, sizeof(int), 1, fp);
+fwrite(&metric, sizeof(int), 1, fp);
+fwrite(sources, sizeof(int), sourceCount, fp);
+fwrite(targets, sizeof(int), targetCount, fp);
+fwrite(costs, sizeof(int), (size_t)sourceCount * targetCount, fp);
+fclose(fp);
+return 1;
+}
+void buildCostMatrix() {
+int sources[MAX_STATIONS];
+int targets[MAX_STATIONS];
+int format;
+printf("\n");
+printf("================================================================================\n");
+printf(" ORIGIN-DESTINATION COST MATRIX\n");
+printf("================================================================================\n");
+int sourceCount = readStationSet("Enter source station IDs (e.g. 0,8,25 or ALL): ", sources);
+if(sourceCount <= 0) {
+printf("\nInvalid source station list!\n");
+return;
+}
+int targetCount = readStationSet("Enter target station IDs (e.g. 0,8,25 or ALL): ", targets);
+if(targetCount <= 0) {
+printf("\nInvalid target station list!\n");
+return;
+}
+int metric = readMetricChoice();
+if(metric == -1) {
+printf("\nInvalid metric!\n");
+return;
+}
+printf("Output format (1. CSV 2. Binary): ");
+scanf("%d", &format);
+if(format != 1 && format != 2) {
+printf("\nInvalid output format!\n");
+return;
+}
+int *costs = (int *)malloc(sizeof(int) * (size_t)sourceCount * targetCount);
+if(costs == NULL) {
+printf("\nOut of memory while allocating cost matrix!\n");
+return;
+}
+struct timespec start;
+clock_gettime(CLOCK_MONOTONIC, &start);
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(bucketCountFor(net, metric, &costWeights) > MAX_BUCKETS) {
+releaseNetwork(MAIN_READER_SLOT);
+free(costs);
+printf("\nWeighted edge costs are too large for the bucket queue; lower the weights.\n");
+return;
+}
+// Tables covering most of the network are cheaper as one dense all-pairs
+// pass than as one search per source
+int threads = 0;
+int dense = metric != METRIC_WEIGHTED && sourceCount * 2 >= totalStations;
+if(dense) {
+int (*allPairs)[PADDED_STATIONS] = NULL;
+if(posix_memalign((void **)&allPairs, DENSE_ALIGNMENT,
+sizeof(int) * PADDED_STATIONS * PADDED_STATIONS) != 0) {
+allPairs = NULL;
+}
+if(allPairs != NULL && denseAllPairs(net, metric, allPairs)) {
+for(int s = 0; s < sourceCount; s++) {
+for(int t = 0; t < targetCount; t++) {
+costs[(long)s * targetCount + t] = allPairs[sources[s]][targets[t]];
+}
+}
+} else {
+dense = 0;
+}
+free(allPairs);
+}
+if(!dense) {
+threads = computeCostMatrix(net, sources, sourceCount, targets, targetCount, metric, costs);
+}
+releaseNetwork(MAIN_READER_SLOT);
+long micros = elapsedMicros(&start);
+const char *fileName = (format == 1) ? MATRIX_CSV_FILE : MATRIX_BIN_FILE;
+int written = (format == 1)
+? writeCostMatrixCSV(fileName, sources, sourceCount, targets, targetCount, metric, costs)
+: writeCostMatrixBinary(fileName, sources, sourceCount, targets, targetCount, metric, costs);
+free(costs);
+if(!written) {
+printf("\nError opening file for writing!\n");
+return;
+}
+if(dense) {
+printf("\n %d x %d %s matrix computed in %ld us with the dense %s kernel.\n",
+sourceCount, targetCount, metricName(metric), micros, denseKernels.name);
+} else {
+printf("\n %d x %d %s matrix computed in %ld us on %d thread(s).\n",
+sourceCount, targetCount, metricName(metric), micros, threads);
+}
+printf(" Matrix saved to '%s' (unreachable pairs are %d).\n", fileName, INFINITY_DIST);
+printf("================================================================================\n");
+}
+// ==================== CUSTOM COST ROUTING ====================
+// Reads alpha (fare) and beta (crowd) for time + alpha*fare + beta*crowd.
+int readCostWeights() {
+float alpha, beta;
+printf("Enter fare weight alpha (minutes per Rs, 0-10, e.g. 0.5): ");
+scanf("%f", &alpha);
+printf("Enter crowd weight beta (minutes per crowd level, 0-10, e.g. 1): ");
+scanf("%f", &beta);
+if(alpha < 0 || alpha > 10 || beta < 0 || beta > 10) {
+printf("\nWeights must be between 0 and 10!\n");
+return 0;
+}
+costWeights.timeWeight = WEIGHT_SCALE;
+costWeights.fareWeight = (int)(alpha * WEIGHT_SCALE + 0.5f);
+costWeights.crowdWeight = (int)(beta * WEIGHT_SCALE + 0.5f);
+return 1;
+}
+void findBestRouteByCost() {
+char sourceName[50], destName[50];
+printf("\n");
+printf("================================================================================\n");
+printf(" BEST ROUTE BY CUSTOM COST\n");
+printf("================================================================================\n");
+printf("Enter source station name: ");
+scanf(" %[^\n]", sourceName);
+int source = getStationIndexByName(sourceName);
+if(source == -1) {
+printf("\nSource station not found!\n");
+return;
+}
+printf("Enter destination station name: ");
+scanf(" %[^\n]", destName);
+int dest = getStationIndexByName(destName);
+if(dest == -1) {
+printf("\nDestination station not found!\n");
+return;
+}
+if(source == dest) {
+printf("\nSource and destination cannot be same!\n");
+return;
+}
+int metric = readMetricChoice();
+if(metric == -1) {
+printf("\nInvalid metric!\n");
+return;
+}
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(reachableWithinBudget(net, source, metric, INT_MAX, scratch) < 0) {
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nWeighted edge costs are too large for the bucket queue; lower the weights.\n");
+return;
+}
+if(!scratch->settled[dest]) {
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nNo routes found between these stations!\n");
+return;
+}
+// Walk the parent links back from the destination
+int reversed[MAX_STATIONS];
+int path[MAX_STATIONS];
+int pathLen = 0;
+for(int v = dest; v != -1; v = scratch->parent[v]) {
+reversed[pathLen++] = v;
+}
+for(int i = 0; i < pathLen; i++) {
+path[i] = reversed[pathLen - 1 - i];
+}
+// PathInfo holds MAX_PATH_LENGTH stations; a cut-off route would stop
+// short of the destination, so longer ones are reported instead of shown
+PathInfo info;
+int displayable = pathLen <= MAX_PATH_LENGTH;
+if(displayable) {
+calculateRouteMetrics(net, path, pathLen, &info);
+}
+int bestCost = scratch->cost[dest];
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nBest route by %s", metricName(metric));
+if(metric == METRIC_WEIGHTED) {
+printf(" (time + %.1f x fare + %.1f x crowd)",
+(float)costWeights.fareWeight / WEIGHT_SCALE, (float)costWeights.crowdWeight / WEIGHT_SCALE);
+}
+printf(": %g %s\n", costInUnits(metric, bestCost), metricUnit(metric));
+printf("--------------------------------------------------------------------------------\n");
+if(displayable) {
+displayDetailedRoute(&info);
+} else {
+printf(" Route has %d stations, too long to display (limit %d).\n", pathLen, MAX_PATH_LENGTH);
+}
+printf("================================================================================\n");
+}
+// Times the metric-specialized kernels against bucketSearchGeneric, which
+// fetches every edge cost through a function pointer, over all sources.
+void benchmarkSearchKernels() {
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+printf("\n");
+printf("================================================================================\n");
+printf(" SEARCH KERNEL BENCHMARK (%d rounds x %d sources)\n", BENCHMARK_ROUNDS, totalStations);
+printf("================================================================================\n");
+printf(" %-15s %15s %15s %10s\n", "Metric", "Specialized", "Generic", "Speedup");
+printf("--------------------------------------------------------------------------------\n");
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+for(int metric = 0; metric < METRIC_COUNT; metric++) {
+int bucketCount = bucketCountFor(net, metric, &costWeights);
+if(bucketCount > MAX_BUCKETS) {
+printf(" %-15s skipped: weighted costs overflow the bucket queue\n", metricName(metric));
+continue;
+}
+long specializedSum = 0, genericSum = 0;
+struct timespec start;
+clock_gettime(CLOCK_MONOTONIC, &start);
+for(int round = 0; round < BENCHMARK_ROUNDS; round++) {
+for(int source = 0; source < totalStations; source++) {
+reachableWithinBudget(net, source, metric, INT_MAX, scratch);
+specializedSum += scratch->cost[scratch->order[scratch->reachedCount - 1]];
+}
+}
+long specializedMicros = elapsedMicros(&start);
+clock_gettime(CLOCK_MONOTONIC, &start);
+for(int round = 0; round < BENCHMARK_ROUNDS; round++) {
+for(int source = 0; source < totalStations; source++) {
+bucketSearchGeneric(net, source, INT_MAX, &costWeights, edgeCostFunctions[metric],
+bucketCount, scratch);
+genericSum += scratch->cost[scratch->order[scratch->reachedCount - 1]];
+}
+}
+long genericMicros = elapsedMicros(&start);
+long searches = (long)BENCHMARK_ROUNDS * totalStations;
+printf(" %-15s %12ld ns %12ld ns %9.2fx%s\n", metricName(metric),
+specializedMicros * 1000 / searches, genericMicros * 1000 / searches,
+specializedMicros > 0 ? (double)genericMicros / specializedMicros : 0.0,
+specializedSum == genericSum ? "" : " MISMATCH");
+}
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("================================================================================\n");
+printf(" Times are per one-to-all search.\n");
+printf("================================================================================\n");
+}
+// ==================== CHANGE JOURNAL ====================
+// Every accepted edge update is appended to JOURNAL_FILE with a sequence
+// number and checksum before its version is published, so an edit costs one
+// small append instead of rewriting the snapshot. Once the journal grows past
+// JOURNAL_COMPACT_THRESHOLD records it is folded into a new snapshot.
+// Recovery loads the snapshot and replays records newer than it, stopping at
+// the first torn or corrupt record. All journal functions expect
+// networkWriteLock to be held.
+void initCrcTable() {
+for(unsigned int i = 0; i < 256; i++) {
+unsigned int c = i;
+for(int k = 0; k < 8; k++) {
+c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+}
+crcTable[i] = c;
+}
+}
+unsigned int crc32(const void *data, size_t length) {
+const unsigned char *bytes = (const unsigned char *)data;
+unsigned int c = 0xFFFFFFFFu;
+for(size_t i = 0; i < length; i++) {
+c = crcTable[(c ^ bytes[i]) & 0xFF] ^ (c >> 8);
+}
+return c ^ 0xFFFFFFFFu;
+}
+int openJournal(const char *mode) {
+if(journalFile != NULL) {
+fclose(journalFile);
+}
+journalFile = fopen(JOURNAL_FILE, mode);
+return journalFile != NULL;
+}
+// Appends one record per update and flushes them to disk with a single sync.
+// Feed batches pass the feed offset they have read up to (-1 otherwise),
+// which is journaled as the last record of the batch.
+int journalEdgeUpdates(const EdgeUpdate updates[], int count, long feedPosition) {
+if(count == 0) return 1;
+if(journalFile == NULL && !openJournal("ab")) {
+return 0;
+}
+int total = (feedPosition >= 0) ? count + 1 : count;
+for(int i = 0; i < total; i++) {
+JournalRecord record;
+memset(&record, 0, sizeof(record));
+record.sequence = ++journalSequence;
+if(i < count) {
+record.from = updates[i].from;
+record.to = updates[i].to;
+record.field = updates[i].field;
+record.value = updates[i].value;
+} else {
+record.from = (int)(feedPosition >> 31);
+record.to = -1;
+record.field = -1;
+record.value = (int)(feedPosition & INT_MAX);
+record.flags = JOURNAL_FEED_OFFSET;
+}
+if(i == total - 1) {
+record.flags |= JOURNAL_BATCH_END;
+}
+record.checksum = crc32(&record, offsetof(JournalRecord, checksum));
+if(fwrite(&record, sizeof(record), 1, journalFile) != 1) {
+return 0;
+}
+journalRecordsSinceSnapshot++;
+}
+if(fflush(journalFile) != 0) {
+return 0;
+}
+fsync(fileno(journalFile));
+if(feedPosition >= 0) {
+journaledFeedOffset = feedPosition;
+}
+return 1;
+}
+// Writes the snapshot to a temporary file and renames it over the old one,
+// so a crash mid-write never leaves a half-written snapshot behind
+int writeSnapshot(const NetworkVersion *net, long sequence) {
+FILE *fp = fopen(SNAPSHOT_TEMP_FILE, "wb");
+if(fp == NULL) {
+return 0;
+}
+SnapshotHeader header;
+memset(&header, 0, sizeof(header));
+strcpy(header.magic, SNAPSHOT_MAGIC);
+header.formatVersion = SNAPSHOT_FORMAT_VERSION;
+header.lastSequence = sequence;
+header.feedOffset = journaledFeedOffset;
+fwrite(&header, sizeof(header), 1, fp);
+fwrite(&totalStations, sizeof(int), 1, fp);
+fwrite(stations, sizeof(Station), totalStations, fp);
+fwrite(net->adjacencyMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
+fwrite(net->fareMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
+fwrite(net->timeMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
+fwrite(net->crowdMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
+fwrite(&totalLines, sizeof(int), 1, fp);
+fwrite(lineNames, sizeof(lineNames[0]), MAX_LINES, fp);
+fwrite(net->lineMatrix, sizeof(int), MAX_STATIONS * MAX_STATIONS, fp);
+int ok = (fflush(fp) == 0 && !ferror(fp));
+if(ok) {
+fsync(fileno(fp));
+}
+fclose(fp);
+if(!ok || rename(SNAPSHOT_TEMP_FILE, SNAPSHOT_FILE) != 0) {
+remove(SNAPSHOT_TEMP_FILE);
+return 0;
+}
+return 1;
+}
+// Returns 1 when a snapshot was read, 0 when none exists, -1 when the file
+// is not a snapshot this version understands or is cut short. Everything is
+// read into a scratch copy of the matrices first, so draft is only touched
+// on success.
+int readSnapshot(NetworkVersion *draft, long *sequence, long *feedPosition) {
+FILE *fp = fopen(SNAPSHOT_FILE, "rb");
+if(fp == NULL) {
+return 0;
+}
+SnapshotHeader header;
+int stationCount;
+if(fread(&header, sizeof(header), 1, fp) != 1 ||
+strncmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+header.formatVersion != SNAPSHOT_FORMAT_VERSION ||
+fread(&stationCount, sizeof(int), 1, fp) != 1 ||
+stationCount < 0 || stationCount > MAX_STATIONS) {
+fclose(fp);
+return -1;
+}
+size_t matrixSize = MAX_STATIONS * MAX_STATIONS;
+Station loaded[MAX_STATIONS];
+char loadedLines[MAX_LINES][30];
+int lineCount;
+struct {
+int adjacencyMatrix[MAX_STATIONS][MAX_STATIONS];
+int fareMatrix[MAX_STATIONS][MAX_STATIONS];
+int timeMatrix[MAX_STATIONS][MAX_STATIONS];
+int crowdMatrix[MAX_STATIONS][MAX_STATIONS];
+int lineMatrix[MAX_STATIONS][MAX_STATIONS];
+} *loadedMatrices = malloc(sizeof(*loadedMatrices));
+int ok = loadedMatrices != NULL &&
+fread(loaded, sizeof(Station), stationCount, fp) == (size_t)stationCount &&
+fread(loadedMatrices->adjacencyMatrix, sizeof(int), matrixSize, fp) == matrixSize &&
+fread(loadedMatrices->fareMatrix, sizeof(int), matrixSize, fp) == matrixSize &&
+fread(loadedMatrices->timeMatrix, sizeof(int), matrixSize, fp) == matrixSize &&
+fread(loadedMatrices->crowdMatrix, sizeof(int), matrixSize, fp) == matrixSize &&
+fread(&lineCount, sizeof(int), 1, fp) == 1 && lineCount >= 0 && lineCount < MAX_LINES &&
+fread(loadedLines, sizeof(loadedLines[0]), MAX_LINES, fp) == MAX_LINES &&
+fread(loadedMatrices->lineMatrix, sizeof(int), matrixSize, fp) == matrixSize;
+fclose(fp);
+if(!ok) {
+free(loadedMatrices);
+return -1;
+}
+memcpy(draft->adjacencyMatrix, loadedMatrices->adjacencyMatrix, sizeof(draft->adjacencyMatrix));
+memcpy(draft->fareMatrix, loadedMatrices->fareMatrix, sizeof(draft->fareMatrix));
+memcpy(draft->timeMatrix, loadedMatrices->timeMatrix, sizeof(draft->timeMatrix));
+memcpy(draft->crowdMatrix, loadedMatrices->crowdMatrix, sizeof(draft->crowdMatrix));
+memcpy(draft->lineMatrix, loadedMatrices->lineMatrix, sizeof(draft->lineMatrix));
+free(loadedMatrices);
+memcpy(stations, loaded, sizeof(Station) * stationCount);
+totalStations = stationCount;
+memcpy(lineNames, loadedLines, sizeof(lineNames));
+totalLines = lineCount;
+*sequence = header.lastSequence;
+*feedPosition = header.feedOffset;
+return 1;
+}
+int compactJournal(const NetworkVersion *net) {
+if(!writeSnapshot(net, journalSequence)) {
+return 0;
+}
+// Records up to journalSequence are now in the snapshot; if we crash
+// before the truncate they are skipped on replay by sequence number
+if(openJournal("wb")) {
+journalRecordsSinceSnapshot = 0;
+}
+return 1;
+}
+// Applies journal records with sequence > afterSequence to draft. Stops at
+// the first torn, corrupt or out-of-order record, drops the unfinished edit
+// it belongs to and cuts the journal there so later appends follow the last
+// complete edit. feedPosition is advanced to the feed offset of the last
+// replayed feed batch. Returns the records applied.
+int replayJournal(NetworkVersion *draft, long afterSequence, long *lastSequence,
+long *feedPosition) {
+*lastSequence = afterSequence;
+FILE *fp = fopen(JOURNAL_FILE, "rb");
+if(fp == NULL) {
+return 0;
+}
+JournalRecord record;
+// Sized for the largest batch any writer produces, grown if a journal holds
+// a bigger one; feed offset records are kept apart and never take a slot
+int pendingCapacity = MAX_FEED_BATCH;
+EdgeUpdate *pending = (EdgeUpdate *)malloc(sizeof(EdgeUpdate) * pendingCapacity);
+int outOfMemory = (pending == NULL);
+int pendingCount = 0;
+long pendingFeedPosition = -1;
+int applied = 0;
+long goodBytes = 0;
+long readBytes = 0;
+long expected = -1;
+while(!outOfMemory && fread(&record, sizeof(record), 1, fp) == 1) {
+if(record.checksum != crc32(&record, offsetof(JournalRecord, checksum))) break;
+if(expected != -1 && record.sequence != expected) break;
+if(record.sequence > afterSequence && !(record.flags & JOURNAL_FEED_OFFSET) &&
+pendingCount == pendingCapacity) {
+EdgeUpdate *grown = (EdgeUpdate *)realloc(pending, sizeof(EdgeUpdate) * pendingCapacity * 2);
+if(grown == NULL) {
+outOfMemory = 1;
+break;
+}
+pending = grown;
+pendingCapacity *= 2;
+}
+expected = record.sequence + 1;
+readBytes += sizeof(record);
+if(record.sequence > afterSequence && (record.flags & JOURNAL_FEED_OFFSET)) {
+pendingFeedPosition = ((long)record.from << 31) | record.value;
+} else if(record.sequence > afterSequence) {
+EdgeUpdate update = { record.from, record.to, record.field, record.value };
+pending[pendingCount++] = update;
+}
+if(record.flags & JOURNAL_BATCH_END) {
+for(int i = 0; i < pendingCount; i++) {
+applyEdgeUpdate(draft, &pending[i]);
+}
+int batchRecords = pendingCount;
+if(pendingFeedPosition >= 0) {
+*feedPosition = pendingFeedPosition;
+batchRecords++;
+}
+if(batchRecords > 0) {
+*lastSequence = record.sequence;
+}
+applied += batchRecords;
+pendingCount = 0;
+pendingFeedPosition = -1;
+goodBytes = readBytes;
+}
+}
+fseek(fp, 0, SEEK_END);
+long fileBytes = ftell(fp);
+fclose(fp);
+free(pending);
+// Running out of memory says nothing about the records left unread, so
+// only a torn or corrupt tail is cut off
+if(outOfMemory) {
+printf("\nWarning: out of memory while replaying '%s'; later edits were not loaded.\n",
+JOURNAL_FILE);
+} else if(fileBytes > goodBytes) {
+truncate(JOURNAL_FILE, goodBytes);
+}
+return applied;
+}
+// Rebuilds the live network from the snapshot (or the built-in network when
+// there is none) plus the journal. Returns 0 if nothing could be read.
+int recoverNetwork() {
+NetworkVersion *draft = beginNetworkEdit();
+long snapshotSequence = 0;
+long feedPosition = 0;
+int snapshotStatus = readSnapshot(draft, &snapshotSequence, &feedPosition);
+// Warn even at startup: the next compaction overwrites the unreadable file
+if(snapshotStatus < 0) {
+printf("\nWarning: '%s' is damaged or not a snapshot in format version %d; ignoring it.\n",
+SNAPSHOT_FILE, SNAPSHOT_FORMAT_VERSION);
+printf("It will be replaced at the next save; move it aside to keep it.\n");
+}
+if(snapshotStatus < 0) {
+snapshotSequence = 0;
+feedPosition = 0;
+}
+long lastSequence;
+int replayed = replayJournal(draft, snapshotSequence, &lastSequence, &feedPosition);
+journalSequence = lastSequence;
+journaledFeedOffset = feedPosition;
+journalRecordsSinceSnapshot = replayed;
+openJournal("ab");
+commitNetworkEdit(draft);
+if(snapshotStatus == 1 || replayed > 0) {
+printf("\nRecovered network: snapshot sequence %ld + %d journal record(s).\n",
+snapshotSequence, replayed);
+}
+return snapshotStatus == 1 || replayed > 0;
+}
+// ==================== TRANSFER-AWARE ROUTING ====================
+const char *lineName(int line) {
+if(line == LOCAL_LINE) return lineNames[LOCAL_LINE];
+if(line < 0 || line >= totalLines) return "Unknown Line";
+return lineNames[line];
+}
+int transferNode(const NetworkVersion *net, int station, int line) {
+unsigned int below = net->stationLineMask[station] & ((1u << line) - 1);
+return net->transferNodeStart[station] + __builtin_popcount(below);
+}
+// Builds the expanded graph from the adjacency index: one node per
+// (station, serving line) and one ride edge per connection, between the
+// nodes of that connection's line at both ends
+void buildTransferGraph(NetworkVersion *net) {
+int node = 0;
+for(int u = 0; u < MAX_STATIONS; u++) {
+unsigned int mask = 0;
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+mask |= 1u << net->lineMatrix[u][net->edgeTarget[e]];
+}
+net->stationLineMask[u] = mask;
+net->transferNodeStart[u] = node;
+net->changeTime[u] = (u < totalStations)
+? MIN_CHANGE_TIME_BASE + MIN_CHANGE_TIME_PER_PLATFORM * stations[u].platform
+: MIN_CHANGE_TIME_BASE;
+for(int line = 0; line < MAX_LINES; line++) {
+if(mask & (1u << line)) {
+net->nodeStation[node] = u;
+net->nodeLine[node] = line;
+node++;
+}
+}
+}
+net->transferNodeStart[MAX_STATIONS] = node;
+net->transferNodeCount = node;
+int ride = 0;
+for(int n = 0; n < node; n++) {
+int u = net->nodeStation[n];
+int line = net->nodeLine[n];
+net->rideStart[n] = ride;
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+if(net->lineMatrix[u][v] == line) {
+net->rideTarget[ride] = transferNode(net, v, line);
+net->rideTime[ride] = net->edgeWeight[METRIC_TIME][e];
+ride++;
+}
+}
+}
+net->rideStart[node] = ride;
+}
+// Fastest route counting each change of line as the station's minimum change
+// time plus penalty. Runs the same bucket queue as the station-level search,
+// seeded with every line node of the source; transfer edges are generated on
+// the fly from the station's node range. Returns the first node settled at
+// dest, or -1 if dest is unreachable.
+int transferAwareRoute(const NetworkVersion *net, int source, int dest, int penalty,
+TransferScratch *scratch) {
+int maxCost = net->maxEdgeWeight[METRIC_TIME];
+for(int u = 0; u < totalStations; u++) {
+if(net->changeTime[u] + penalty > maxCost) {
+maxCost = net->changeTime[u] + penalty;
+}
+}
+int bucketCount = maxCost + 1;
+for(int n = 0; n < net->transferNodeCount; n++) {
+scratch->cost[n] = INT_MAX;
+scratch->settled[n] = 0;
+}
+for(int b = 0; b < bucketCount; b++) {
+scratch->bucketHead[b] = -1;
+}
+int queued = 0;
+// Relaxes node v to newCost via parent u, moving it between buckets
+void relax(int u, int v, int newCost) {
+if(scratch->settled[v] || newCost >= scratch->cost[v]) return;
+if(scratch->cost[v] == INT_MAX) {
+queued++;
+} else {
+int oldBucket = scratch->cost[v] % bucketCount;
+if(scratch->prevInBucket[v] != -1) {
+scratch->nextInBucket[scratch->prevInBucket[v]] = scratch->nextInBucket[v];
+} else {
+scratch->bucketHead[oldBucket] = scratch->nextInBucket[v];
+}
+if(scratch->nextInBucket[v] != -1) {
+scratch->prevInBucket[scratch->nextInBucket[v]] = scratch->prevInBucket[v];
+}
+}
+int newBucket = newCost % bucketCount;
+scratch->cost[v] = newCost;
+scratch->parent[v] = u;
+scratch->prevInBucket[v] = -1;
+scratch->nextInBucket[v] = scratch->bucketHead[newBucket];
+if(scratch->bucketHead[newBucket] != -1) {
+scratch->prevInBucket[scratch->bucketHead[newBucket]] = v;
+}
+scratch->bucketHead[newBucket] = v;
+}
+for(int n = net->transferNodeStart[source]; n < net->transferNodeStart[source + 1]; n++) {
+relax(-1, n, 0);
+}
+int cursor = 0;
+while(queued > 0) {
+int b = cursor % bucketCount;
+int u = scratch->bucketHead[b];
+if(u == -1) {
+cursor++;
+continue;
+}
+scratch->bucketHead[b] = scratch->nextInBucket[u];
+if(scratch->bucketHead[b] != -1) {
+scratch->prevInBucket[scratch->bucketHead[b]] = -1;
+}
+queued--;
+scratch->settled[u] = 1;
+int station = net->nodeStation[u];
+if(station == dest) {
+return u;
+}
+for(int r = net->rideStart[u]; r < net->rideStart[u + 1]; r++) {
+relax(u, net->rideTarget[r], cursor + net->rideTime[r]);
+}
+int change = cursor + net->changeTime[station] + penalty;
+for(int n = net->transferNodeStart[station]; n < net->transferNodeStart[station + 1]; n++) {
+relax(u, n, change);
+}
+}
+return -1;
+}
+void findTransferAwareRoute() {
+char sourceName[50], destName[50];
+int penalty;
+printf("\n");
+printf("================================================================================\n");
+printf(" TRANSFER-AWARE ROUTE\n");
+printf("================================================================================\n");
+printf("Enter source station name: ");
+scanf(" %[^\n]", sourceName);
+int source = getStationIndexByName(sourceName);
+if(source == -1) {
+printf("\nSource station not found!\n");
+return;
+}
+printf("Enter destination station name: ");
+scanf(" %[^\n]", destName);
+int dest = getStationIndexByName(destName);
+if(dest == -1) {
+printf("\nDestination station not found!\n");
+return;
+}
+if(source == dest) {
+printf("\nSource and destination cannot be same!\n");
+return;
+}
+printf("Enter transfer penalty (0-%d minutes): ", MAX_TRANSFER_PENALTY);
+scanf("%d", &penalty);
+if(penalty < 0 || penalty > MAX_TRANSFER_PENALTY) {
+printf("\nInvalid transfer penalty!\n");
+return;
+}
+TransferScratch *scratch = (TransferScratch *)malloc(sizeof(TransferScratch));
+if(scratch == NULL) {
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+int end = transferAwareRoute(net, source, dest, penalty, scratch);
+if(end == -1) {
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nNo routes found between these stations!\n");
+return;
+}
+int nodes[MAX_TRANSFER_NODES];
+int nodeCount = 0;
+for(int n = end; n != -1; n = scratch->parent[n]) {
+nodes[nodeCount++] = n;
+}
+printf("\nFastest route with transfers (%d min incl. penalties, expanded graph: %d nodes for %d stations)\n",
+scratch->cost[end], net->transferNodeCount, totalStations);
+printf("--------------------------------------------------------------------------------\n");
+// nodes[] runs from destination back to source; consecutive nodes at the
+// same station are a change of line
+int transfers = 0;
+int changeMinutes = 0;
+int legStart = nodes[nodeCount - 1];
+printf(" Board %s at %s\n", lineName(net->nodeLine[legStart]), stations[net->nodeStation[legStart]].name);
+for(int i = nodeCount - 2; i >= 0; i--) {
+int from = nodes[i + 1];
+int to = nodes[i];
+if(net->nodeStation[from] == net->nodeStation[to]) {
+int station = net->nodeStation[to];
+int wait = scratch->cost[to] - scratch->cost[from];
+printf(" Ride to %s (%d min)\n", stations[station].name, scratch->cost[from] - scratch->cost[legStart]);
+printf(" Change at %s (platform %d): %s -> %s (%d min change + %d min penalty)\n",
+stations[station].name, stations[station].platform,
+lineName(net->nodeLine[from]), lineName(net->nodeLine[to]),
+wait - penalty, penalty);
+transfers++;
+changeMinutes += wait - penalty;
+legStart = to;
+}
+}
+printf(" Ride to %s (%d min)\n", stations[dest].name, scratch->cost[end] - scratch->cost[legStart]);
+printf(" Stops:");
+for(int i = nodeCount - 1; i >= 0; i--) {
+if(i == nodeCount - 1 || net->nodeStation[nodes[i]] != net->nodeStation[nodes[i + 1]]) {
+printf(" %s%s", stations[net->nodeStation[nodes[i]]].name, i > 0 ? " ->" : "");
+}
+}
+printf("\n");
+printf(" Total Time: %d minutes (%d min changing, excluding penalties)\n",
+scratch->cost[end] - transfers * penalty, changeMinutes);
+printf(" Transfers: %d\n", transfers);
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("================================================================================\n");
+}
+// ==================== ALTERNATIVE ROUTES ====================
+// Plateau method: with a shortest-path tree from the source and one from the
+// destination (connections are bidirectional, so a search from the
+// destination gives the reverse tree), a plateau is a chain of connections
+// that lies on both trees. Every plateau yields a via-route; routes with long
+// plateaus are preferred because they do not just swap one detour in and out.
+int legCost(const NetworkVersion *net, int metric, int from, int to) {
+switch(metric) {
+case METRIC_DISTANCE: return net->adjacencyMatrix[from][to];
+case METRIC_FARE: return net->fareMatrix[from][to];
+case METRIC_TIME: return net->timeMatrix[from][to];
+case METRIC_CROWD: return net->crowdMatrix[from][to];
+default:
+return costWeights.timeWeight * net->timeMatrix[from][to] +
+costWeights.fareWeight * net->fareMatrix[from][to] +
+costWeights.crowdWeight * net->crowdMatrix[from][to];
+}
+}
+// Orders candidates by the cost spent off their plateau, so routes whose
+// shared-tree section is long come first; ties go to the cheaper route
+int compareAlternativesByPlateau(const void *a, const void *b) {
+AlternativeRoute *routeA = (AlternativeRoute *)a;
+AlternativeRoute *routeB = (AlternativeRoute *)b;
+int offPlateauA = routeA->cost - routeA->plateauCost;
+int offPlateauB = routeB->cost - routeB->plateauCost;
+if(offPlateauA != offPlateauB) {
+return offPlateauA - offPlateauB;
+}
+return routeA->cost - routeB->cost;
+}
+// Fills routes[] with up to MAX_ALTERNATIVES routes, shortest first. Each
+// later route stays within ALT_MAX_STRETCH_PERCENT of the shortest cost and
+// shares at most ALT_MAX_OVERLAP_PERCENT of its cost with routes already
+// chosen. Returns the number of routes, 0 if dest is unreachable.
+int findAlternativeRoutes(const NetworkVersion *net, int source, int dest, int metric,
+SearchScratch *forward, SearchScratch *backward, AlternativeRoute routes[]) {
+if(reachableWithinBudget(net, source, metric, INT_MAX, forward) < 0 ||
+reachableWithinBudget(net, dest, metric, INT_MAX, backward) < 0 ||
+!forward->settled[dest]) {
+return 0;
+}
+int shortest = forward->cost[dest];
+// A connection u -> v is on both trees when forward reaches v from u and
+// backward reaches u from v; a plateau starts at a station where no such
+// connection arrives
+AlternativeRoute candidates[MAX_STATIONS];
+int candidateCount = 0;
+for(int a = 0; a < totalStations; a++) {
+if(!forward->settled[a] || !backward->settled[a]) continue;
+int p = forward->parent[a];
+if(p != -1 && backward->parent[p] == a) continue;
+int b = a;
+while(b != dest && forward->parent[backward->parent[b]] == b) {
+b = backward->parent[b];
+}
+AlternativeRoute *route = &candidates[candidateCount];
+route->cost = forward->cost[a] + backward->cost[a];
+route->plateauCost = forward->cost[b] - forward->cost[a];
+if((long)route->cost * 100 > (long)shortest * ALT_MAX_STRETCH_PERCENT) continue;
+// Source -> a along the forward tree, then a -> dest along the backward tree
+int reversed[MAX_STATIONS];
+int count = 0;
+for(int v = a; v != -1; v = forward->parent[v]) {
+reversed[count++] = v;
+}
+if(count > MAX_PATH_LENGTH) continue;
+route->pathLength = 0;
+for(int i = count - 1; i >= 0; i--) {
+route->stations[route->pathLength++] = reversed[i];
+}
+int onRoute[MAX_STATIONS] = { 0 };
+for(int i = 0; i < route->pathLength; i++) {
+onRoute[route->stations[i]] = 1;
+}
+int simple = 1;
+for(int v = backward->parent[a]; v != -1 && simple; v = backward->parent[v]) {
+if(onRoute[v] || route->pathLength == MAX_PATH_LENGTH) {
+simple = 0;
+break;
+}
+onRoute[v] = 1;
+route->stations[route->pathLength++] = v;
+}
+if(simple) {
+candidateCount++;
+}
+}
+qsort(candidates, candidateCount, sizeof(AlternativeRoute), compareAlternativesByPlateau);
+// Greedily keep candidates that add enough new connections
+char chosenLeg[MAX_STATIONS][MAX_STATIONS];
+memset(chosenLeg, 0, sizeof(chosenLeg));
+int routeCount = 0;
+for(int c = 0; c < candidateCount && routeCount < MAX_ALTERNATIVES; c++) {
+AlternativeRoute *route = &candidates[c];
+long shared = 0;
+for(int i = 1; i < route->pathLength; i++) {
+if(chosenLeg[route->stations[i-1]][route->stations[i]]) {
+shared += legCost(net, metric, route->stations[i-1], route->stations[i]);
+}
+}
+route->overlapPercent = route->cost > 0 ? (int)(shared * 100 / route->cost) : 0;
+if(routeCount > 0 && route->overlapPercent > ALT_MAX_OVERLAP_PERCENT) continue;
+for(int i = 1; i < route->pathLength; i++) {
+chosenLeg[route->stations[i-1]][route->stations[i]] = 1;
+chosenLeg[route->stations[i]][route->stations[i-1]] = 1;
+}
+routes[routeCount++] = *route;
+}
+return routeCount;
+}
+void displayAlternativeRoutes() {
+char sourceName[50], destName[50];
+printf("\n");
+printf("================================================================================\n");
+printf(" DIVERSE ALTERNATIVE ROUTES\n");
+printf("================================================================================\n");
+printf("Enter source station name: ");
+scanf(" %[^\n]", sourceName);
+int source = getStationIndexByName(sourceName);
+if(source == -1) {
+printf("\nSource station not found!\n");
+return;
+}
+printf("Enter destination station name: ");
+scanf(" %[^\n]", destName);
+int dest = getStationIndexByName(destName);
+if(dest == -1) {
+printf("\nDestination station not found!\n");
+return;
+}
+if(source == dest) {
+printf("\nSource and destination cannot be same!\n");
+return;
+}
+int metric = readMetricChoice();
+if(metric == -1) {
+printf("\nInvalid metric!\n");
+return;
+}
+SearchScratch *forward = (SearchScratch *)malloc(sizeof(SearchScratch));
+SearchScratch *backward = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(forward == NULL || backward == NULL) {
+free(forward);
+free(backward);
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+AlternativeRoute routes[MAX_ALTERNATIVES];
+struct timespec start;
+clock_gettime(CLOCK_MONOTONIC, &start);
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+int routeCount = findAlternativeRoutes(net, source, dest, metric, forward, backward, routes);
+long micros = elapsedMicros(&start);
+if(routeCount == 0) {
+printf("\nNo routes found between these stations!\n");
+}
+for(int i = 0; i < routeCount; i++) {
+PathInfo info;
+calculateRouteMetrics(net, routes[i].stations, routes[i].pathLength, &info);
+printf("\nRoute #%d (%s: %g %s", i+1, metricName(metric), costInUnits(metric, routes[i].cost),
+metricUnit(metric));
+if(i > 0) {
+printf(", +%d%% over best, %d%% shared with routes above",
+(routes[i].cost - routes[0].cost) * 100 / (routes[0].cost > 0 ? routes[0].cost : 1),
+routes[i].overlapPercent);
+}
+printf(")\n");
+printf("--------------------------------------------------------------------------------\n");
+displayDetailedRoute(&info);
+}
+releaseNetwork(MAIN_READER_SLOT);
+free(forward);
+free(backward);
+printf("\n %d route(s) computed in %ld us.\n", routeCount, micros);
+printf("================================================================================\n");
+}
+// ==================== NETWORK ANALYTICS ====================
+// Labels every station with its connected component by breadth-first search
+// over the adjacency index
+void buildConnectivityIndex(NetworkVersion *net) {
+int queue[MAX_STATIONS];
+for(int i = 0; i < MAX_STATIONS; i++) {
+net->componentId[i] = -1;
+}
+net->componentCount = 0;
+for(int start = 0; start < totalStations; start++) {
+if(net->componentId[start] != -1) continue;
+int head = 0, tail = 0;
+queue[tail++] = start;
+net->componentId[start] = net->componentCount;
+while(head < tail) {
+int u = queue[head++];
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+if(v < totalStations && net->componentId[v] == -1) {
+net->componentId[v] = net->componentCount;
+queue[tail++] = v;
+}
+}
+}
+net->componentCount++;
+}
+}
+// Brandes' dependency accumulation for one source. The bucket-queue search
+// settles stations in non-decreasing cost order, which is the order shortest
+// path counts propagate in; requiring the successor to settle later keeps
+// zero-cost connections from counting paths twice.
+void accumulateBetweenness(const NetworkVersion *net, int source, int metric, BrandesScratch *scratch) {
+SearchScratch *search = &scratch->search;
+int reached = reachableWithinBudget(net, source, metric, INT_MAX, search);
+if(reached <= 0) return;
+for(int i = 0; i < reached; i++) {
+int u = search->order[i];
+scratch->position[u] = i;
+scratch->sigma[u] = 0;
+scratch->delta[u] = 0;
+}
+scratch->sigma[source] = 1;
+for(int i = 0; i < reached; i++) {
+int u = search->order[i];
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+if(v < totalStations && search->settled[v] && scratch->position[v] > i &&
+search->cost[v] == search->cost[u] + legCost(net, metric, u, v)) {
+scratch->sigma[v] += scratch->sigma[u];
+}
+}
+}
+for(int i = reached - 1; i >= 0; i--) {
+int u = search->order[i];
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+if(v < totalStations && search->settled[v] && scratch->position[v] > i &&
+search->cost[v] == search->cost[u] + legCost(net, metric, u, v)) {
+scratch->delta[u] += scratch->sigma[u] / scratch->sigma[v] * (1.0 + scratch->delta[v]);
+}
+}
+if(u != source) {
+scratch->centrality[u] += scratch->delta[u];
+}
+}
+}
+void *betweennessWorker(void *arg) {
+BetweennessWorker *worker = (BetweennessWorker *)arg;
+BetweennessJob *job = worker->job;
+int source;
+while((source = atomic_fetch_add(&job->nextSource, 1)) < totalStations) {
+accumulateBetweenness(job->net, source, job->metric, worker->scratch);
+}
+return NULL;
+}
+// Betweenness centrality of every station over shortest paths by metric,
+// with sources spread over one worker per core. Connections are
+// bidirectional, so each pair is counted from both ends and halved.
+// The caller keeps net pinned. Returns the thread count, 0 on failure.
+int computeBetweenness(const NetworkVersion *net, int metric, double centrality[]) {
+BetweennessJob job;
+job.net = net;
+job.metric = metric;
+atomic_init(&job.nextSource, 0);
+long cores = sysconf(_SC_NPROCESSORS_ONLN);
+int threadCount = (cores < 1) ? 1 : (cores > MAX_READER_THREADS ? MAX_READER_THREADS : (int)cores);
+BrandesScratch *scratches = (BrandesScratch *)calloc(threadCount, sizeof(BrandesScratch));
+if(scratches == NULL) {
+return 0;
+}
+BetweennessWorker workers[MAX_READER_THREADS];
+pthread_t threads[MAX_READER_THREADS];
+int started = 0;
+for(int i = 0; i < threadCount; i++) {
+workers[i].job = &job;
+workers[i].scratch = &scratches[i];
+}
+for(int i = 1; i < threadCount; i++) {
+if(pthread_create(&threads[started], NULL, betweennessWorker, &workers[i]) == 0) {
+started++;
+}
+}
+betweennessWorker(&workers[0]);
+for(int i = 0; i < started; i++) {
+pthread_join(threads[i], NULL);
+}
+for(int u = 0; u < totalStations; u++) {
+centrality[u] = 0;
+for(int t = 0; t < threadCount; t++) {
+centrality[u] += scratches[t].centrality[u];
+}
+centrality[u] /= 2.0;
+}
+free(scratches);
+return started + 1;
+}
+// Tarjan's low-link bridge search with an explicit stack. A connection
+// u - v is a bridge when nothing below v in the DFS tree reaches above it.
+// Returns the number of bridges written to bridgeFrom/bridgeTo.
+int findBridges(const NetworkVersion *net, int bridgeFrom[], int bridgeTo[]) {
+int discovery[MAX_STATIONS];
+int low[MAX_STATIONS];
+int parent[MAX_STATIONS];
+int nextEdge[MAX_STATIONS];
+int stack[MAX_STATIONS];
+int timer = 0;
+int bridgeCount = 0;
+for(int i = 0; i < totalStations; i++) {
+discovery[i] = -1;
+}
+for(int root = 0; root < totalStations; root++) {
+if(discovery[root] != -1) continue;
+int top = 0;
+stack[top++] = root;
+parent[root] = -1;
+discovery[root] = low[root] = timer++;
+nextEdge[root] = net->edgeStart[root];
+while(top > 0) {
+int u = stack[top - 1];
+if(nextEdge[u] < net->edgeStart[u + 1]) {
+int v = net->edgeTarget[nextEdge[u]++];
+if(v >= totalStations || v == parent[u]) continue;
+if(discovery[v] == -1) {
+parent[v] = u;
+discovery[v] = low[v] = timer++;
+nextEdge[v] = net->edgeStart[v];
+stack[top++] = v;
+} else if(discovery[v] < low[u]) {
+low[u] = discovery[v];
+}
+} else {
+top--;
+int p = parent[u];
+if(p != -1) {
+if(low[u] < low[p]) {
+low[p] = low[u];
+}
+if(low[u] > discovery[p]) {
+bridgeFrom[bridgeCount] = p;
+bridgeTo[bridgeCount] = u;
+bridgeCount++;
+}
+}
+}
+}
+}
+return bridgeCount;
+}
+void displayNetworkAnalytics() {
+printf("\n");
+printf("================================================================================\n");
+printf(" NETWORK ANALYTICS\n");
+printf("================================================================================\n");
+int metric = readMetricChoice();
+if(metric == -1) {
+printf("\nInvalid metric!\n");
+return;
+}
+double centrality[MAX_STATIONS];
+int bridgeFrom[MAX_STATIONS], bridgeTo[MAX_STATIONS];
+struct timespec start;
+clock_gettime(CLOCK_MONOTONIC, &start);
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(bucketCountFor(net, metric, &costWeights) > MAX_BUCKETS) {
+releaseNetwork(MAIN_READER_SLOT);
+printf("\nWeighted edge costs are too large for the bucket queue; lower the weights.\n");
+return;
+}
+int threads = computeBetweenness(net, metric, centrality);
+long centralityMicros = elapsedMicros(&start);
+int bridgeCount = findBridges(net, bridgeFrom, bridgeTo);
+int componentSize[MAX_STATIONS] = { 0 };
+for(int i = 0; i < totalStations; i++) {
+componentSize[net->componentId[i]]++;
+}
+printf("\n Connected Components: %d\n", net->componentCount);
+printf("--------------------------------------------------------------------------------\n");
+for(int c = 0; c < net->componentCount; c++) {
+printf(" Component %d: %d station(s)\n", c + 1, componentSize[c]);
+}
+printf("\n Bridges (connections whose loss splits the network): %d\n", bridgeCount);
+printf("--------------------------------------------------------------------------------\n");
+for(int i = 0; i < bridgeCount; i++) {
+printf(" %s <-> %s\n", stations[bridgeFrom[i]].name, stations[bridgeTo[i]].name);
+}
+releaseNetwork(MAIN_READER_SLOT);
+if(threads == 0) {
+printf("\nOut of memory while allocating analytics scratch!\n");
+return;
+}
+// Selection of the top hubs by betweenness
+int ranked[MAX_STATIONS];
+for(int i = 0; i < totalStations; i++) {
+ranked[i] = i;
+}
+int shown = totalStations < TOP_HUBS ? totalStations : TOP_HUBS;
+for(int i = 0; i < shown; i++) {
+for(int j = i + 1; j < totalStations; j++) {
+if(centrality[ranked[j]] > centrality[ranked[i]]) {
+int tmp = ranked[i];
+ranked[i] = ranked[j];
+ranked[j] = tmp;
+}
+}
+}
+double pairs = (totalStations > 2) ? (double)(totalStations - 1) * (totalStations - 2) / 2.0 : 1.0;
+printf("\n Top %d Hubs by Betweenness (%s shortest paths)\n", shown, metricName(metric));
+printf("--------------------------------------------------------------------------------\n");
+printf(" %-4s %-25s %12s %12s\n", "Rank", "Station", "Betweenness", "Normalized");
+for(int i = 0; i < shown; i++) {
+printf(" %-4d %-25s %12.1f %12.3f\n", i + 1, stations[ranked[i]].name,
+centrality[ranked[i]], centrality[ranked[i]] / pairs);
+}
+printf("\n Betweenness computed in %ld us on %d thread(s).\n", centralityMicros, threads);
+printf("================================================================================\n");
+}
+// ==================== SPATIAL INDEX ====================
+// Equirectangular projection around Delhi; over the size of the NCR the
+// error against great-circle distance is well under one percent
+void projectCoordinates(double latitude, double longitude, double *x, double *y) {
+double toRadians = M_PI / 180.0;
+*x = EARTH_RADIUS_KM * longitude * toRadians * cos(REFERENCE_LATITUDE * toRadians);
+*y = EARTH_RADIUS_KM * latitude * toRadians;
+}
+void buildKdTree(NetworkVersion *net, int lo, int hi, int depth) {
+if(hi - lo <= 1) return;
+const double *key = (depth % 2 == 0) ? net->stationX : net->stationY;
+int mid = (lo + hi) / 2;
+// Quickselect the median of kdOrder[lo..hi) into position mid
+int left = lo, right = hi - 1;
+while(left < right) {
+double pivot = key[net->kdOrder[(left + right) / 2]];
+int i = left, j = right;
+while(i <= j) {
+while(key[net->kdOrder[i]] < pivot) i++;
+while(key[net->kdOrder[j]] > pivot) j--;
+if(i <= j) {
+int tmp = net->kdOrder[i];
+net->kdOrder[i] = net->kdOrder[j];
+net->kdOrder[j] = tmp;
+i++;
+j--;
+}
+}
+if(mid <= j) {
+right = j;
+} else if(mid >= i) {
+left = i;
+} else {
+break;
+}
+}
+buildKdTree(net, lo, mid, depth + 1);
+buildKdTree(net, mid + 1, hi, depth + 1);
+}
+void buildSpatialIndex(NetworkVersion *net) {
+net->hasCoordinates = totalStations > 0;
+for(int i = 0; i < totalStations; i++) {
+if(stations[i].latitude == 0 && stations[i].longitude == 0) {
+net->hasCoordinates = 0;
+}
+projectCoordinates(stations[i].latitude, stations[i].longitude, &net->stationX[i], &net->stationY[i]);
+net->kdOrder[i] = i;
+}
+buildKdTree(net, 0, totalStations, 0);
+for(int m = 0; m < STORED_METRICS; m++) {
+net->heuristicScale[m] = net->hasCoordinates ? INFINITY_DIST : 0;
+}
+if(!net->hasCoordinates) return;
+for(int u = 0; u < totalStations; u++) {
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+if(v >= totalStations) continue;
+double km = planarDistance(net, v, net->stationX[u], net->stationY[u]);
+if(km <= 0) continue;
+for(int m = 0; m < STORED_METRICS; m++) {
+if(net->edgeWeight[m][e] / km < net->heuristicScale[m]) {
+net->heuristicScale[m] = net->edgeWeight[m][e] / km;
+}
+}
+}
+}
+for(int m = 0; m < STORED_METRICS; m++) {
+if(net->heuristicScale[m] >= INFINITY_DIST) {
+net->heuristicScale[m] = 0;
+}
+}
+}
+double planarDistance(const NetworkVersion *net, int station, double x, double y) {
+double dx = net->stationX[station] - x;
+double dy = net->stationY[station] - y;
+return sqrt(dx * dx + dy * dy);
+}
+// k nearest stations, closest first. Returns how many were found.
+int nearestStations(const NetworkVersion *net, double latitude, double longitude, int k,
+NearbyStation nearest[]) {
+double x, y;
+int found = 0;
+projectCoordinates(latitude, longitude, &x, &y);
+if(k > totalStations) k = totalStations;
+void search(int lo, int hi, int depth) {
+if(lo >= hi) return;
+int mid = (lo + hi) / 2;
+int station = net->kdOrder[mid];
+double distance = planarDistance(net, station, x, y);
+if(found < k || distance < nearest[found - 1].distanceKm) {
+// Insert into the sorted result list, dropping the farthest if full
+int i = (found < k) ? found++ : k - 1;
+while(i > 0 && nearest[i - 1].distanceKm > distance) {
+nearest[i] = nearest[i - 1];
+i--;
+}
+nearest[i].station = station;
+nearest[i].distanceKm = distance;
+}
+double split = (depth % 2 == 0) ? x - net->stationX[station] : y - net->stationY[station];
+int nearLo = split < 0 ? lo : mid + 1;
+int nearHi = split < 0 ? mid : hi;
+int farLo = split < 0 ? mid + 1 : lo;
+int farHi = split < 0 ? hi : mid;
+search(nearLo, nearHi, depth + 1);
+if(found < k || fabs(split) < nearest[found - 1].distanceKm) {
+search(farLo, farHi, depth + 1);
+}
+}
+search(0, totalStations, 0);
+return found;
+}
+// All stations within radiusKm, in no particular order. Returns the count.
+int stationsWithinRadius(const NetworkVersion *net, double latitude, double longitude,
+double radiusKm, NearbyStation found[]) {
+double x, y;
+int count = 0;
+projectCoordinates(latitude, longitude, &x, &y);
+void search(int lo, int hi, int depth) {
+if(lo >= hi) return;
+int mid = (lo + hi) / 2;
+int station = net->kdOrder[mid];
+double distance = planarDistance(net, station, x, y);
+if(distance <= radiusKm) {
+found[count].station = station;
+found[count].distanceKm = distance;
+count++;
+}
+double split = (depth % 2 == 0) ? x - net->stationX[station] : y - net->stationY[station];
+if(split - radiusKm <= 0) search(lo, mid, depth + 1);
+if(split + radiusKm >= 0) search(mid + 1, hi, depth + 1);
+}
+search(0, totalStations, 0);
+return count;
+}
+// A* on a stored metric with the straight-line lower bound. Keys are
+// cost + floor(scale * km to dest); flooring keeps the bound consistent, so
+// keys never decrease and the bucket queue stays valid with a ring of
+// 2 * maxEdgeWeight + 2 buckets. Returns the cost to dest or -1.
+int astarRoute(const NetworkVersion *net, int source, int dest, int metric, SearchScratch *scratch) {
+const int *weight = net->edgeWeight[metric];
+double scale = net->heuristicScale[metric];
+int bucketCount = 2 * net->maxEdgeWeight[metric] + 2;
+if(bucketCount > MAX_BUCKETS) {
+scale = 0;
+bucketCount = net->maxEdgeWeight[metric] + 1;
+}
+int estimate[MAX_STATIONS];
+for(int i = 0; i < totalStations; i++) {
+estimate[i] = (int)floor(scale * planarDistance(net, i, net->stationX[dest], net->stationY[dest]));
+scratch->cost[i] = INT_MAX;
+scratch->settled[i] = 0;
+}
+for(int b = 0; b < bucketCount; b++) {
+scratch->bucketHead[b] = -1;
+}
+scratch->reachedCount = 0;
+scratch->cost[source] = 0;
+scratch->parent[source] = -1;
+int cursor = estimate[source];
+scratch->bucketHead[cursor % bucketCount] = source;
+scratch->nextInBucket[source] = -1;
+scratch->prevInBucket[source] = -1;
+int queued = 1;
+while(queued > 0) {
+int b = cursor % bucketCount;
+int u = scratch->bucketHead[b];
+if(u == -1) {
+cursor++;
+continue;
+}
+scratch->bucketHead[b] = scratch->nextInBucket[u];
+if(scratch->bucketHead[b] != -1) {
+scratch->prevInBucket[scratch->bucketHead[b]] = -1;
+}
+queued--;
+scratch->settled[u] = 1;
+scratch->order[scratch->reachedCount++] = u;
+if(u == dest) {
+return scratch->cost[u];
+}
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+int v = net->edgeTarget[e];
+int newCost = scratch->cost[u] + weight[e];
+if(v >= totalStations || scratch->settled[v] || newCost >= scratch->cost[v]) {
+continue;
+}
+if(scratch->cost[v] == INT_MAX) {
+queued++;
+} else {
+int oldBucket = (scratch->cost[v] + estimate[v]) % bucketCount;
+if(scratch->prevInBucket[v] != -1) {
+scratch->nextInBucket[scratch->prevInBucket[v]] = scratch->nextInBucket[v];
+} else {
+scratch->bucketHead[oldBucket] = scratch->nextInBucket[v];
+}
+if(scratch->nextInBucket[v] != -1) {
+scratch->prevInBucket[scratch->nextInBucket[v]] = scratch->prevInBucket[v];
+}
+}
+int newBucket = (newCost + estimate[v]) % bucketCount;
+scratch->cost[v] = newCost;
+scratch->parent[v] = u;
+scratch->prevInBucket[v] = -1;
+scratch->nextInBucket[v] = scratch->bucketHead[newBucket];
+if(scratch->bucketHead[newBucket] != -1) {
+scratch->prevInBucket[scratch->bucketHead[newBucket]] = v;
+}
+scratch->bucketHead[newBucket] = v;
+}
+}
+return -1;
+}
+void displayNearestStations() {
+double latitude, longitude, radius;
+int k;
+printf("\n");
+printf("================================================================================\n");
+printf(" NEAREST STATIONS\n");
+printf("================================================================================\n");
+printf("Enter latitude and longitude (e.g. 28.6280 77.2190): ");
+scanf("%lf %lf", &latitude, &longitude);
+printf("Enter number of nearest stations (1-%d): ", MAX_NEAREST);
+scanf("%d", &k);
+printf("Enter search radius (km, 0 to skip): ");
+scanf("%lf", &radius);
+if(k < 1 || k > MAX_NEAREST || radius < 0) {
+printf("\nInvalid query!\n");
+return;
+}
+NearbyStation nearest[MAX_NEAREST];
+NearbyStation inRadius[MAX_STATIONS];
+struct timespec start;
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(!net->hasCoordinates) {
+releaseNetwork(MAIN_READER_SLOT);
+printf("\nStation coordinates are missing; import them first.\n");
+return;
+}
+clock_gettime(CLOCK_MONOTONIC, &start);
+int found = nearestStations(net, latitude, longitude, k, nearest);
+long nearestMicros = elapsedMicros(&start);
+clock_gettime(CLOCK_MONOTONIC, &start);
+int within = (radius > 0) ? stationsWithinRadius(net, latitude, longitude, radius, inRadius) : 0;
+long radiusMicros = elapsedMicros(&start);
+releaseNetwork(MAIN_READER_SLOT);
+printf("\n %d nearest station(s) (%ld us):\n", found, nearestMicros);
+printf("--------------------------------------------------------------------------------\n");
+for(int i = 0; i < found; i++) {
+printf(" %-25s %6.2f km\n", stations[nearest[i].station].name, nearest[i].distanceKm);
+}
+if(radius > 0) {
+printf("\n %d station(s) within %.1f km (%ld us):\n", within, radius, radiusMicros);
+printf("--------------------------------------------------------------------------------\n");
+for(int i = 0; i < within; i++) {
+printf(" %-25s %6.2f km\n", stations[inRadius[i].station].name, inRadius[i].distanceKm);
+}
+}
+printf("================================================================================\n");
+}
+// Tries the nearest few stations as boarding points, adding the walk to each
+// in the chosen metric, and keeps the cheapest complete journey
+void findRouteFromCoordinates() {
+double latitude, longitude;
+char destName[50];
+int choice;
+printf("\n");
+printf("================================================================================\n");
+printf(" ROUTE FROM GPS LOCATION\n");
+printf("================================================================================\n");
+printf("Enter latitude and longitude (e.g. 28.6280 77.2190): ");
+scanf("%lf %lf", &latitude, &longitude);
+printf("Enter destination station name: ");
+scanf(" %[^\n]", destName);
+int dest = getStationIndexByName(destName);
+if(dest == -1) {
+printf("\nDestination station not found!\n");
+return;
+}
+printf("Optimize (1. Distance 2. Time): ");
+scanf("%d", &choice);
+if(choice != 1 && choice != 2) {
+printf("\nInvalid metric!\n");
+return;
+}
+int metric = (choice == 1) ? METRIC_DISTANCE : METRIC_TIME;
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+if(scratch == NULL) {
+printf("\nOut of memory while allocating search scratch!\n");
+return;
+}
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+if(!net->hasCoordinates) {
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nStation coordinates are missing; import them first.\n");
+return;
+}
+struct timespec start;
+clock_gettime(CLOCK_MONOTONIC, &start);
+NearbyStation nearest[NEAREST_CANDIDATES];
+int candidates = nearestStations(net, latitude, longitude, NEAREST_CANDIDATES, nearest);
+int bestTotal = INT_MAX, bestWalk = 0, bestStart = -1, settledTotal = 0;
+int bestPath[MAX_STATIONS], bestLength = 0;
+for(int c = 0; c < candidates; c++) {
+int board = nearest[c].station;
+int walk = (metric == METRIC_DISTANCE)
+? (int)ceil(nearest[c].distanceKm)
+: (int)ceil(nearest[c].distanceKm * WALK_MINUTES_PER_KM);
+int ride = (board == dest) ? 0 : astarRoute(net, board, dest, metric, scratch);
+if(board != dest) {
+settledTotal += scratch->reachedCount;
+}
+if(ride < 0 || walk + ride >= bestTotal) continue;
+bestTotal = walk + ride;
+bestWalk = walk;
+bestStart = board;
+bestLength = 0;
+if(board == dest) {
+bestPath[bestLength++] = dest;
+} else {
+int reversed[MAX_STATIONS], count = 0;
+for(int v = dest; v != -1; v = scratch->parent[v]) {
+reversed[count++] = v;
+}
+for(int i = count - 1; i >= 0; i--) {
+bestPath[bestLength++] = reversed[i];
+}
+}
+}
+long micros = elapsedMicros(&start);
+if(bestStart == -1) {
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("\nNo routes found to this station from the nearest stations!\n");
+return;
+}
+printf("\n Walk to %s (%d %s), then ride:\n", stations[bestStart].name, bestWalk, metricUnit(metric));
+printf("--------------------------------------------------------------------------------\n");
+if(bestLength > MAX_PATH_LENGTH) {
+printf(" Route has %d stations, too long to display (limit %d).\n", bestLength, MAX_PATH_LENGTH);
+} else if(bestLength > 1) {
+PathInfo info;
+calculateRouteMetrics(net, bestPath, bestLength, &info);
+displayDetailedRoute(&info);
+} else {
+printf(" You are already closest to %s.\n", stations[dest].name);
+}
+printf(" Total %s incl. walk: %d %s\n", metricName(metric), bestTotal, metricUnit(metric));
+printf("\n Tried %d boarding station(s); A* settled %d station(s) in %ld us.\n",
+candidates, settledTotal, micros);
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+printf("================================================================================\n");
+}
+// Reads "<station id>,<latitude>,<longitude>" lines from COORDINATES_FILE,
+// publishes a version with the rebuilt spatial index and writes a snapshot so
+// the coordinates survive a restart
+void importStationCoordinates() {
+FILE *fp = fopen(COORDINATES_FILE, "r");
+if(fp == NULL) {
+printf("\nError opening '%s' for reading!\n", COORDINATES_FILE);
+return;
+}
+char line[128];
+int imported = 0, rejected = 0;
+int id;
+double latitude, longitude;
+NetworkVersion *draft = beginNetworkEdit();
+while(fgets(line, sizeof(line), fp) != NULL) {
+if(line[0] == '#' || line[0] == '\n') continue;
+if(sscanf(line, "%d , %lf , %lf", &id, &latitude, &longitude) != 3 ||
+id < 0 || id >= totalStations ||
+latitude < -90 || latitude > 90 || longitude < -180 || longitude > 180) {
+rejected++;
+continue;
+}
+stations[id].latitude = latitude;
+stations[id].longitude = longitude;
+imported++;
+}
+fclose(fp);
+commitNetworkEdit(draft);
+pthread_mutex_lock(&networkWriteLock);
+int saved = compactJournal(atomic_load(&liveNetwork));
+pthread_mutex_unlock(&networkWriteLock);
+printf("\nImported coordinates for %d station(s), %d line(s) rejected.\n", imported, rejected);
+if(!saved) {
+printf("Warning: could not write '%s'; coordinates are not durable.\n", SNAPSHOT_FILE);
+}
+}
+// ==================== DENSE SIMD KERNELS ====================
+// For networks this small the dense matrices fit in cache, so whole-row
+// min-plus updates beat following adjacency lists. Both kernels are built
+// from two row primitives:
+//   MIN_PLUS(dst, src, add, n): dst[j] = min(dst[j], add + src[j])
+//   MIN_OF_MAX(a, b, n):        min over j of max(a[j], b[j])
+// DEFINE_DENSE_KERNELS stamps the kernels out once per instruction set with
+// the matching target attribute so the primitives inline; the variant is
+// picked once at startup from what the CPU supports.
+void buildDenseMatrices(NetworkVersion *net) {
+for(int m = 0; m < STORED_METRICS; m++) {
+for(int i = 0; i < PADDED_STATIONS; i++) {
+for(int j = 0; j < PADDED_STATIONS; j++) {
+net->denseMatrix[m][i][j] = (i == j) ? 0 : DENSE_INFINITY;
+}
+}
+for(int u = 0; u < MAX_STATIONS; u++) {
+for(int e = net->edgeStart[u]; e < net->edgeStart[u + 1]; e++) {
+net->denseMatrix[m][u][net->edgeTarget[e]] = net->edgeWeight[m][e];
+}
+}
+}
+}
+static inline void minPlusRowScalar(int *dst, const int *src, int add, int n) {
+for(int j = 0; j < n; j++) {
+int candidate = add + src[j];
+if(candidate < dst[j]) dst[j] = candidate;
+}
+}
+static inline int minOfMaxScalar(const int *a, const int *b, int n) {
+int best = INT_MAX;
+for(int j = 0; j < n; j++) {
+int value = a[j] > b[j] ? a[j] : b[j];
+if(value < best) best = value;
+}
+return best;
+}
+#ifdef DENSE_X86
+__attribute__((target("sse4.1")))
+static inline void minPlusRowSSE(int *dst, const int *src, int add, int n) {
+__m128i addend = _mm_set1_epi32(add);
+for(int j = 0; j < n; j += 4) {
+__m128i candidate = _mm_add_epi32(addend, _mm_load_si128((const __m128i *)(src + j)));
+_mm_store_si128((__m128i *)(dst + j), _mm_min_epi32(_mm_load_si128((const __m128i *)(dst + j)), candidate));
+}
+}
+__attribute__((target("sse4.1")))
+static inline int horizontalMinSSE(__m128i v) {
+v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+return _mm_cvtsi128_si32(v);
+}
+__attribute__((target("sse4.1")))
+static inline int minOfMaxSSE(const int *a, const int *b, int n) {
+__m128i best = _mm_set1_epi32(INT_MAX);
+for(int j = 0; j < n; j += 4) {
+__m128i value = _mm_max_epi32(_mm_load_si128((const __m128i *)(a + j)), _mm_load_si128((const __m128i *)(b + j)));
+best = _mm_min_epi32(best, value);
+}
+return horizontalMinSSE(best);
+}
+__attribute__((target("avx2")))
+static inline void minPlusRowAVX2(int *dst, const int *src, int add, int n) {
+__m256i addend = _mm256_set1_epi32(add);
+for(int j = 0; j < n; j += 8) {
+__m256i candidate = _mm256_add_epi32(addend, _mm256_load_si256((const __m256i *)(src + j)));
+_mm256_store_si256((__m256i *)(dst + j), _mm256_min_epi32(_mm256_load_si256((const __m256i *)(dst + j)), candidate));
+}
+}
+__attribute__((target("avx2")))
+static inline int minOfMaxAVX2(const int *a, const int *b, int n) {
+__m256i best = _mm256_set1_epi32(INT_MAX);
+for(int j = 0; j < n; j += 8) {
+__m256i value = _mm256_max_epi32(_mm256_load_si256((const __m256i *)(a + j)), _mm256_load_si256((const __m256i *)(b + j)));
+best = _mm256_min_epi32(best, value);
+}
+__m128i half = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+half = _mm_min_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+half = _mm_min_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+return _mm_cvtsi128_si32(half);
+}
+__attribute__((target("avx512f")))
+static inline void minPlusRowAVX512(int *dst, const int *src, int add, int n) {
+__m512i addend = _mm512_set1_epi32(add);
+for(int j = 0; j < n; j += 16) {
+__m512i candidate = _mm512_add_epi32(addend, _mm512_load_si512((const void *)(src + j)));
+_mm512_store_si512((void *)(dst + j), _mm512_min_epi32(_mm512_load_si512((const void *)(dst + j)), candidate));
+}
+}
+__attribute__((target("avx512f")))
+static inline int minOfMaxAVX512(const int *a, const int *b, int n) {
+__m512i best = _mm512_set1_epi32(INT_MAX);
+for(int j = 0; j < n; j += 16) {
+__m512i value = _mm512_max_epi32(_mm512_load_si512((const void *)(a + j)), _mm512_load_si512((const void *)(b + j)));
+best = _mm512_min_epi32(best, value);
+}
+return _mm512_reduce_min_epi32(best);
+}
+#endif
+// oneToAll is Dijkstra on the dense matrix: each step picks the cheapest
+// open station with MIN_OF_MAX (settled stations are masked to infinity)
+// and relaxes its whole row with MIN_PLUS. allPairs is Floyd-Warshall in
+// DENSE_BLOCK x DENSE_BLOCK tiles: the pivot tile, then its row and column
+// of tiles, then the rest, so each phase works on rows already in cache.
+#define DEFINE_DENSE_KERNELS(suffix, TARGET_ATTRIBUTE, MIN_PLUS, MIN_OF_MAX) \
+TARGET_ATTRIBUTE \
+static void denseOneToAll##suffix(const int matrix[][PADDED_STATIONS], int source, int dist[]) { \
+int open[PADDED_STATIONS] __attribute__((aligned(DENSE_ALIGNMENT))); \
+for(int j = 0; j < PADDED_STATIONS; j++) { \
+dist[j] = DENSE_INFINITY; \
+open[j] = (j < totalStations) ? 0 : DENSE_INFINITY; \
+} \
+dist[source] = 0; \
+for(int step = 0; step < totalStations; step++) { \
+int best = MIN_OF_MAX(dist, open, PADDED_STATIONS); \
+if(best >= DENSE_INFINITY) break; \
+int u = 0; \
+while(open[u] != 0 || dist[u] != best) u++; \
+open[u] = DENSE_INFINITY; \
+MIN_PLUS(dist, matrix[u], best, PADDED_STATIONS); \
+} \
+} \
+TARGET_ATTRIBUTE \
+static void denseTile##suffix(int matrix[][PADDED_STATIONS], int ib, int jb, int kb) { \
+for(int k = kb; k < kb + DENSE_BLOCK; k++) { \
+for(int i = ib; i < ib + DENSE_BLOCK; i++) { \
+MIN_PLUS(&matrix[i][jb], &matrix[k][jb], matrix[i][k], DENSE_BLOCK); \
+} \
+} \
+} \
+TARGET_ATTRIBUTE \
+static void denseAllPairs##suffix(int matrix[][PADDED_STATIONS]) { \
+for(int kb = 0; kb < PADDED_STATIONS; kb += DENSE_BLOCK) { \
+denseTile##suffix(matrix, kb, kb, kb); \
+for(int b = 0; b < PADDED_STATIONS; b += DENSE_BLOCK) { \
+if(b == kb) continue; \
+denseTile##suffix(matrix, kb, b, kb); \
+denseTile##suffix(matrix, b, kb, kb); \
+} \
+for(int ib = 0; ib < PADDED_STATIONS; ib += DENSE_BLOCK) { \
+if(ib == kb) continue; \
+for(int jb = 0; jb < PADDED_STATIONS; jb += DENSE_BLOCK) { \
+if(jb == kb) continue; \
+denseTile##suffix(matrix, ib, jb, kb); \
+} \
+} \
+} \
+}
+DEFINE_DENSE_KERNELS(Scalar, , minPlusRowScalar, minOfMaxScalar)
+#ifdef DENSE_X86
+DEFINE_DENSE_KERNELS(SSE, __attribute__((target("sse4.1"))), minPlusRowSSE, minOfMaxSSE)
+DEFINE_DENSE_KERNELS(AVX2, __attribute__((target("avx2"))), minPlusRowAVX2, minOfMaxAVX2)
+DEFINE_DENSE_KERNELS(AVX512, __attribute__((target("avx512f"))), minPlusRowAVX512, minOfMaxAVX512)
+#endif
+// Fills kernels[] with every variant this CPU can run, widest first.
+// Returns the count; the scalar fallback is always last.
+int availableDenseKernels(DenseKernels kernels[]) {
+int count = 0;
+#ifdef DENSE_X86
+__builtin_cpu_init();
+if(__builtin_cpu_supports("avx512f")) {
+kernels[count++] = (DenseKernels){ "AVX-512", denseOneToAllAVX512, denseAllPairsAVX512 };
+}
+if(__builtin_cpu_supports("avx2")) {
+kernels[count++] = (DenseKernels){ "AVX2", denseOneToAllAVX2, denseAllPairsAVX2 };
+}
+if(__builtin_cpu_supports("sse4.1")) {
+kernels[count++] = (DenseKernels){ "SSE4.1", denseOneToAllSSE, denseAllPairsSSE };
+}
+#endif
+kernels[count++] = (DenseKernels){ "Scalar", denseOneToAllScalar, denseAllPairsScalar };
+return count;
+}
+void selectDenseKernels() {
+DenseKernels kernels[MAX_DENSE_KERNELS];
+availableDenseKernels(kernels);
+denseKernels = kernels[0];
+}
+// All-pairs costs for a stored metric into an aligned padded matrix, with
+// unreachable pairs set to INFINITY_DIST. Returns 0 for the weighted metric.
+int denseAllPairs(const NetworkVersion *net, int metric, int costs[][PADDED_STATIONS]) {
+if(metric == METRIC_WEIGHTED) return 0;
+memcpy(costs, net->denseMatrix[metric], sizeof(net->denseMatrix[metric]));
+denseKernels.allPairs(costs);
+for(int i = 0; i < PADDED_STATIONS; i++) {
+for(int j = 0; j < PADDED_STATIONS; j++) {
+if(costs[i][j] >= DENSE_INFINITY) costs[i][j] = INFINITY_DIST;
+}
+}
+return 1;
+}
+// Times every available dense variant against the bucket-queue search for
+// one-to-all (all sources) and all-pairs, checking each result against it
+void benchmarkDenseKernels() {
+DenseKernels kernels[MAX_DENSE_KERNELS];
+int kernelCount = availableDenseKernels(kernels);
+SearchScratch *scratch = (SearchScratch *)malloc(sizeof(SearchScratch));
+int (*reference)[PADDED_STATIONS] = NULL;
+int (*work)[PADDED_STATIONS] = NULL;
+size_t matrixBytes = sizeof(int) * PADDED_STATIONS * PADDED_STATIONS;
+if(posix_memalign((void **)&reference, DENSE_ALIGNMENT, matrixBytes) != 0) reference = NULL;
+if(posix_memalign((void **)&work, DENSE_ALIGNMENT, matrixBytes) != 0) work = NULL;
+if(scratch == NULL || reference == NULL || work == NULL) {
+free(scratch);
+free(reference);
+free(work);
+printf("\nOut of memory while allocating benchmark buffers!\n");
+return;
+}
+int dist[PADDED_STATIONS] __attribute__((aligned(DENSE_ALIGNMENT)));
+int metric = METRIC_TIME;
+long searches = (long)BENCHMARK_ROUNDS * totalStations;
+struct timespec start;
+printf("\n");
+printf("================================================================================\n");
+printf(" DENSE KERNEL BENCHMARK (%s, %d stations padded to %d, %d rounds)\n",
+metricName(metric), totalStations, PADDED_STATIONS, BENCHMARK_ROUNDS);
+printf("================================================================================\n");
+printf(" %-14s %16s %16s %8s\n", "Kernel", "One-to-all", "All-pairs", "Check");
+printf("--------------------------------------------------------------------------------\n");
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+// Reference: the bucket-queue search from every source
+clock_gettime(CLOCK_MONOTONIC, &start);
+for(int round = 0; round < BENCHMARK_ROUNDS; round++) {
+for(int source = 0; source < totalStations; source++) {
+reachableWithinBudget(net, source, metric, INT_MAX, scratch);
+if(round == 0) {
+for(int j = 0; j < PADDED_STATIONS; j++) {
+reference[source][j] = (j < totalStations && scratch->settled[j]) ? scratch->cost[j] : DENSE_INFINITY;
+}
+}
+}
+}
+long bucketMicros = elapsedMicros(&start);
+printf(" %-14s %13ld ns %13ld us %8s\n", "Bucket queue", bucketMicros * 1000 / searches,
+bucketMicros / BENCHMARK_ROUNDS, "-");
+for(int k = 0; k < kernelCount; k++) {
+int matches = 1;
+clock_gettime(CLOCK_MONOTONIC, &start);
+for(int round = 0; round < BENCHMARK_ROUNDS; round++) {
+for(int source = 0; source < totalStations; source++) {
+kernels[k].oneToAll(net->denseMatrix[metric], source, dist);
+if(round == 0) {
+for(int j = 0; j < totalStations; j++) {
+if(dist[j] != reference[source][j]) matches = 0;
+}
+}
+}
+}
+long oneToAllMicros = elapsedMicros(&start);
+clock_gettime(CLOCK_MONOTONIC, &start);
+for(int round = 0; round < BENCHMARK_ROUNDS; round++) {
+memcpy(work, net->denseMatrix[metric], matrixBytes);
+kernels[k].allPairs(work);
+}
+long allPairsMicros = elapsedMicros(&start);
+for(int i = 0; i < totalStations; i++) {
+for(int j = 0; j < totalStations; j++) {
+if(work[i][j] != reference[i][j]) matches = 0;
+}
+}
+printf(" %-14s %13ld ns %13ld us %8s\n", kernels[k].name, oneToAllMicros * 1000 / searches,
+allPairsMicros / BENCHMARK_ROUNDS, matches ? "OK" : "MISMATCH");
+}
+releaseNetwork(MAIN_READER_SLOT);
+free(scratch);
+free(reference);
+free(work);
+printf("================================================================================\n");
+printf(" One-to-all is per source; all-pairs is per full matrix (bucket queue: all\n");
+printf(" sources). Active kernel: %s.\n", denseKernels.name);
+printf("================================================================================\n");
+}
+// ==================== SELF TEST ====================
+// Regression checks built with -DSELF_TEST in place of the menu. They run in
+// a scratch directory so the journal and snapshot next to the program are
+// left alone; the exit status is non-zero if any check fails.
+#ifdef SELF_TEST
+int selfTestFailures = 0;
+void selfCheck(int passed, const char *description) {
+printf(" [%s] %s\n", passed ? "PASS" : "FAIL", description);
+if(!passed) {
+selfTestFailures++;
+}
+}
+// A full feed batch is MAX_FEED_BATCH updates plus its feed offset record
+void selfTestJournalReplay() {
+EdgeUpdate batch[MAX_FEED_BATCH];
+for(int i = 0; i < MAX_FEED_BATCH; i++) {
+EdgeUpdate update = { 0, 1, FIELD_TIME, 10 + i };
+batch[i] = update;
+}
+NetworkVersion *draft = beginNetworkEdit();
+openJournal("wb");
+journalSequence = 0;
+int written = journalEdgeUpdates(batch, MAX_FEED_BATCH, 4242);
+NetworkVersion *replayed = cloneNetwork(draft);
+long lastSequence = 0, feedPosition = 0;
+int applied = replayJournal(replayed, 0, &lastSequence, &feedPosition);
+FILE *fp = fopen(JOURNAL_FILE, "rb");
+long journalBytes = -1;
+if(fp != NULL) {
+fseek(fp, 0, SEEK_END);
+journalBytes = ftell(fp);
+fclose(fp);
+}
+selfCheck(written && applied == MAX_FEED_BATCH + 1 && lastSequence == MAX_FEED_BATCH + 1,
+"a full feed batch is replayed completely");
+selfCheck(replayed->timeMatrix[0][1] == 10 + MAX_FEED_BATCH - 1 && feedPosition == 4242,
+"replay restores the batch's last value and feed offset");
+selfCheck(journalBytes == (long)((MAX_FEED_BATCH + 1) * sizeof(JournalRecord)),
+"replay keeps every record of a full batch in the journal");
+free(replayed);
+fclose(journalFile);
+journalFile = NULL;
+remove(JOURNAL_FILE);
+abortNetworkEdit(draft);
+}
+// An over-long line must be skipped, not stall the feed at its first byte
+void selfTestFeedReader() {
+FILE *fp = fopen(FEED_FILE, "w+");
+if(fp == NULL) {
+selfCheck(0, "feed reader test file can be created");
+return;
+}
+fputc('#', fp);
+for(int i = 0; i < 200; i++) {
+fputc('x', fp);
+}
+fputs("\n0 1 time 42\n0 1 time", fp);
+fflush(fp);
+long complete = 202 + (long)strlen("0 1 time 42\n");
+long offset = 0;
+long rejectedBefore = atomic_load(&feedRecordsRejected);
+EdgeUpdate batch[MAX_FEED_BATCH];
+int batchSize = readFeedBatch(fp, &offset, batch);
+selfCheck(batchSize == 1 && batch[0].value == 42,
+"the feed reader skips an over-long line and reads the record after it");
+selfCheck(offset == complete && atomic_load(&feedRecordsRejected) == rejectedBefore + 1,
+"the over-long line is rejected and a partial last line is left for later");
+fclose(fp);
+remove(FEED_FILE);
+}
+void selfTestFeedConnections() {
+const NetworkVersion *net = acquireNetwork(MAIN_READER_SLOT);
+EdgeUpdate existing = { 0, 1, FIELD_TIME, 42 };
+EdgeUpdate created = { 3, 20, FIELD_DISTANCE, 5 };
+selfCheck(net->adjacencyMatrix[3][20] == INFINITY_DIST && !feedRecordAllowed(net, &created),
+"a feed record cannot create a connection from a single field");
+selfCheck(feedRecordAllowed(net, &existing), "a feed record can change an existing connection");
+releaseNetwork(MAIN_READER_SLOT);
+}
+int runSelfTests() {
+char directory[] = "bus-selftest-XXXXXX";
+if(mkdtemp(directory) == NULL || chdir(directory) != 0) {
+printf("\nError creating a scratch directory for the self test!\n");
+return 1;
+}
+printf(" SELF TEST\n");
+printf("================================================================================\n");
+selfTestJournalReplay();
+selfTestFeedReader();
+selfTestFeedConnections();
+printf("================================================================================\n");
+printf(" %d check(s) failed.\n", selfTestFailures);
+if(chdir("..") == 0) {
+rmdir(directory);
+}
+return selfTestFailures > 0;
+}
+#endif